@@ -8,15 +8,31 @@
  * easily and correctly.
  *
  * Whether a BIOS wrapper function could output depends
- * on whether corresponding macro is set. The macro 
+ * on whether corresponding macro is set. The macro
  * defines the service number while using SWI instruction.
  *
  * For ARM instruction, the macro should be named as
- * __bios_svcid_arm_*.
+ * __bios_arm_svcid_*. The wrapper __bios_arm_* will be
+ * out-of-line ARM functions defined in combios.c.
+ *
+ * For thumb instruction, the macro should be named as
+ * __bios_thumb_svcid_*. The wrapper __bios_thumb_* will
+ * be inlined into the thumb caller, so that no mode switch
+ * or interworking veneer is required for a BIOS call.
+ *
+ * The __bios_* (without instruction set) names will be
+ * resolved to the thumb wrapper when compiling under
+ * thumb mode (__thumb__ defined), otherwise the ARM one.
  *
  * @see http://problemkaputt.de/gbatek.htm#biosfunctions
  */
 
+// Stringify the service number so that it could be
+// placed into the SWI instruction.
+#define __bios_val(mac) #mac
+#define __bios_tostring(mac) __bios_val(mac)
+#define __bios_swi(mac) "swi " __bios_tostring(mac) ";"
+
 // Avoid name mangling in C++.
 #ifdef __cplusplus
 extern "C" {
@@ -45,7 +61,7 @@ void __bios_arm_cpufastset(
 /**
  * Utilize the fast-set function to fill words.
  */
-void __bios_arm_cpufastfill(void* destinationAddress, 
+void __bios_arm_cpufastfill(void* destinationAddress,
 	int word, unsigned int numWords);
 
 /**
@@ -56,6 +72,127 @@ void __bios_arm_cpufastcopy(void* destinationAddress,
 
 #endif
 
+#if defined(__thumb__) && defined(__bios_thumb_svcid_cpufastset)
+
+/**
+ * Thumb flavour of the fast-set function. See the ARM
+ * flavour for the meaning of each parameters.
+ */
+static inline void __bios_thumb_cpufastset(
+	void* sourceAddress,
+	void* destinationAddress,
+	int wordAmountMode) {
+
+	// The BIOS takes its parameters in r0 - r2 and may
+	// clobber r0 - r3 on return.
+	register void* r0 asm("r0") = sourceAddress;
+	register void* r1 asm("r1") = destinationAddress;
+	register int r2 asm("r2") = wordAmountMode;
+	asm volatile (__bios_swi(__bios_thumb_svcid_cpufastset)
+		: "+r"(r0), "+r"(r1), "+r"(r2) :: "r3", "memory");
+}
+
+/**
+ * Utilize the thumb fast-set function to fill words.
+ */
+static inline void __bios_thumb_cpufastfill(
+	void* destinationAddress,
+	int word, unsigned int numWords) {
+
+	// The filling word must reside in memory, see also
+	// the __bios_arm_cpufastfill in combios.c.
+	volatile int stackWord = word;
+	__bios_thumb_cpufastset((void*)&stackWord,
+		destinationAddress, numWords | (1 << 24));
+}
+
+/**
+ * Utilize the thumb fast-set function to copy words.
+ */
+static inline void __bios_thumb_cpufastcopy(
+	void* destinationAddress, void* sourceAddress,
+	unsigned int numWords) {
+
+	__bios_thumb_cpufastset(sourceAddress,
+		destinationAddress, numWords);
+}
+
+#define __bios_cpufastset  __bios_thumb_cpufastset
+#define __bios_cpufastfill __bios_thumb_cpufastfill
+#define __bios_cpufastcopy __bios_thumb_cpufastcopy
+
+#elif defined(__bios_arm_svcid_cpufastset)
+
+#define __bios_cpufastset  __bios_arm_cpufastset
+#define __bios_cpufastfill __bios_arm_cpufastfill
+#define __bios_cpufastcopy __bios_arm_cpufastcopy
+
+#endif
+
+#ifdef __bios_arm_svcid_intrwait
+
+/**
+ * Halt the CPU until one of the specified interrupts occurs.
+ * The interrupt handler should set the corresponding bits in
+ * the interrupt check flags, the BIOS will clear them on return.
+ *
+ * @param[in] discardOld whether to discard the interrupts that
+ * have already occurred (when 1) or return immediately (when 0).
+ * @param[in] flags the mask of interrupts to wait for.
+ */
+void __bios_arm_intrwait(int discardOld, int flags);
+
+#endif
+
+#ifdef __bios_arm_svcid_vblankintrwait
+
+/**
+ * Halt the CPU until the next vertical blank interrupt occurs.
+ * Just like the intrwait function with discardOld = 1 and the
+ * flags set to vertical blank.
+ */
+void __bios_arm_vblankintrwait();
+
+#endif
+
+#if defined(__thumb__) && defined(__bios_thumb_svcid_intrwait)
+
+/**
+ * Thumb flavour of the intrwait function.
+ */
+static inline void __bios_thumb_intrwait(int discardOld, int flags) {
+	register int r0 asm("r0") = discardOld;
+	register int r1 asm("r1") = flags;
+	asm volatile (__bios_swi(__bios_thumb_svcid_intrwait)
+		: "+r"(r0), "+r"(r1) :: "r2", "r3", "memory");
+}
+
+#define __bios_intrwait __bios_thumb_intrwait
+
+#elif defined(__bios_arm_svcid_intrwait)
+
+#define __bios_intrwait __bios_arm_intrwait
+
+#endif
+
+#if defined(__thumb__) && defined(__bios_thumb_svcid_vblankintrwait)
+
+/**
+ * Thumb flavour of the vblankintrwait function.
+ */
+static inline void __bios_thumb_vblankintrwait() {
+	asm volatile (__bios_swi(__bios_thumb_svcid_vblankintrwait)
+		::: "r0", "r1", "r2", "r3", "memory");
+}
+
+#define __bios_vblankintrwait __bios_thumb_vblankintrwait
+
+#elif defined(__bios_arm_svcid_vblankintrwait)
+
+#define __bios_vblankintrwait __bios_arm_vblankintrwait
+
+#endif
+
 // End of avoid name mangling in C++.
 #ifdef __cplusplus
 }
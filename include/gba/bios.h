@@ -9,6 +9,12 @@
  * not be defined.
  */
 
+#define __bios_thumb_svcid_intrwait 0x04
+#define __bios_arm_svcid_intrwait 0x040000
+
+#define __bios_thumb_svcid_vblankintrwait 0x05
+#define __bios_arm_svcid_vblankintrwait 0x050000
+
 #define __bios_thumb_svcid_cpufastset 0x0C
 #define __bios_arm_svcid_cpufastset 0x0C0000
 
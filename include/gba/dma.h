@@ -0,0 +1,209 @@
+#pragma once
+/**
+ * gba/dma.h - DMA definition for GBA.
+ * @author Haoran Luo
+ *
+ * Defines structure of each DMA registers, and symbol
+ * for accessing those registers. Please notice that the
+ * symbol of those register should be resolved on the
+ * linking stage with specific linker script.
+ *
+ * On top of the registers, a job queue is defined over
+ * the DMA3 channel. The submitted transfers are started
+ * one after another from the DMA completion interrupt,
+ * so the caller never needs to poll the channel.
+ *
+ * @see http://problemkaputt.de/gbatek.htm#gbadmatransfers
+ */
+
+// Avoid name mangling when compiled in C++ source.
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Defines the adjustment of the DMA source and destination address.
+enum __gba_dma_adjust {
+	dmaadj_increment = 0,
+	dmaadj_decrement = 1,
+	dmaadj_fixed     = 2,
+	dmaadj_reload    = 3	// Increment and reload, destination only.
+};
+
+// Defines when the DMA transfer should start.
+enum __gba_dma_timing {
+	dmatime_immediate = 0,
+	dmatime_vblank    = 1,
+	dmatime_hblank    = 2,
+	dmatime_special   = 3
+};
+
+// Defines the DMA control register's structure.
+// See the DMA Transfers topic on GBATEK for details.
+typedef union {
+	// Accessing the register as bit fields.
+	struct {
+		unsigned short unused             : 5;
+
+		// The adjustment of addresses after each unit.
+		unsigned short destination_adjust : 2;
+		unsigned short source_adjust      : 2;
+
+		// Restart the transfer on next timing event.
+		unsigned short repeat             : 1;
+
+		// The transfer unit (0 for halfword, 1 for word).
+		unsigned short word               : 1;
+
+		// The game pak DRQ, which is only for DMA3.
+		unsigned short gamepak_drq        : 1;
+
+		// When should the transfer start.
+		unsigned short timing             : 2;
+
+		// Raise interrupt when the transfer is finished.
+		unsigned short irq_enabled        : 1;
+
+		// Enable the transfer, cleared when finished.
+		unsigned short enabled            : 1;
+	} bits;
+
+	// Accessing the register as half word.
+	unsigned short halfword;
+} __gba_dma_control_t;
+
+// Defines the registers of a DMA channel.
+typedef struct {
+	// The source and destination address, write only.
+	const void* source;
+	void* destination;
+
+	// The number of units to transfer, write only.
+	unsigned short count;
+
+	// The control register of this channel.
+	__gba_dma_control_t control;
+} __gba_dma_channel_t;
+
+// The register locations for DMA registers.
+#define __gba_dma_maxchannels 4
+extern volatile __gba_dma_channel_t __gba_dma[__gba_dma_maxchannels];
+
+/// The ticket of a submitted DMA job, zero for invalid ticket.
+typedef unsigned int __gba_dma_ticket_t;
+
+/// The maximum number of jobs pending in the queue.
+#define __gba_dma_maxjobs 16
+
+// Defines the flags of a DMA job.
+enum __gba_dma_flag {
+	dmaflg_none        = 0,
+
+	// Transfer in halfword, otherwise in word.
+	dmaflg_halfword    = 1 << 0,
+
+	// Keep the destination fixed, for FIFO and registers.
+	dmaflg_dstfixed    = dmaadj_fixed << 5,
+
+	// Keep the source fixed, filling the destination with it.
+	dmaflg_fill        = dmaadj_fixed << 7
+};
+
+/**
+ * @brief Initialize the DMA job queue.
+ *
+ * The queue attaches itself to the interrupt dispatcher, and the
+ * interrupt master register should be enabled by the user.
+ */
+void __gba_dma_init();
+
+/**
+ * @brief Submit a DMA job to the queue.
+ *
+ * The jobs will be run on DMA3 in the order of submission. A job
+ * will wait for its timing event after the previous job is finished.
+ * The source must remain valid until the job is finished.
+ *
+ * @param source the start of the source.
+ * @param destination the start of the destination.
+ * @param units the number of words (or halfwords) to transfer,
+ * which should be at most 0x10000.
+ * @param flags the combination of __gba_dma_flag.
+ * @param timing the __gba_dma_timing to start the transfer, which
+ * should be one of immediate, vblank and hblank.
+ * @return the ticket of the job, or zero when the queue is full or
+ * the parameters are invalid.
+ */
+__gba_dma_ticket_t __gba_dma_submit(const void* source,
+	volatile void* destination, unsigned int units,
+	int flags, int timing);
+
+/**
+ * @brief Check whether a DMA job has finished.
+ */
+int __gba_dma_done(__gba_dma_ticket_t ticket);
+
+/**
+ * @brief Wait for a DMA job to finish.
+ *
+ * The CPU will be halted with BIOS IntrWait function until the job
+ * is finished, so the interrupt master register must be enabled.
+ */
+void __gba_dma_wait(__gba_dma_ticket_t ticket);
+
+/// The number of scanlines in a scanline table.
+#define __gba_hdma_scanlines 160
+
+/**
+ * @brief Start streaming scanline tables into registers.
+ *
+ * A scanline table holds the units for each of the visible scanlines,
+ * which will be written into the destination registers on each HBlank
+ * with DMA0, in HBlank repeat mode. The DMA is restarted on each VBlank,
+ * where the first scanline is written by the CPU.
+ *
+ * Two tables are required, the CPU fills the back table while the front
+ * table is playing, and commits it to be played from next frame. The
+ * DMA might read one row beyond the table at the last scanline, which
+ * will be overwritten at VBlank before it is visible.
+ *
+ * @param destination the first register to write, e.g. the BG scroll,
+ * the affine parameters, the window bounds or a palette entry.
+ * @param front the table to play from next frame.
+ * @param back the table for the CPU to fill.
+ * @param units the number of words (or halfwords) for each scanline.
+ * @param flags the dmaflg_halfword could be specified.
+ * @return zero if the parameters are invalid, otherwise non-zero.
+ */
+int __gba_hdma_start(volatile void* destination,
+	const void* front, void* back, unsigned int units, int flags);
+
+/**
+ * @brief Stop streaming scanline tables.
+ */
+void __gba_hdma_stop();
+
+/**
+ * @brief Retrieve the back table for the CPU to fill.
+ *
+ * @return the back table, or null if the committed table has not
+ * been swapped in yet, under which case please wait for VBlank.
+ */
+void* __gba_hdma_back();
+
+/**
+ * @brief Commit the back table, so that it will be played from next
+ * frame, and the table playing will become the back table.
+ */
+void __gba_hdma_commit();
+
+// End of avoid name mangling when compiled in C++ source.
+#ifdef __cplusplus
+}
+
+// Perform some static assertion (of c++11) to ensure the
+// size of the specified registers.
+static_assert(sizeof(__gba_dma_control_t) == 2,
+	"The structure of GBA DMA control should occupy only 2 bytes.");
+static_assert(sizeof(__gba_dma_channel_t) == 12,
+	"The registers of GBA DMA channel should occupy 12 bytes.");
+#endif
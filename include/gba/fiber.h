@@ -0,0 +1,84 @@
+#pragma once
+/**
+ * gba/fiber.h - Cooperative fibers for GBA.
+ * @author Haoran Luo
+ *
+ * Defines a lightweight cooperative fiber runtime, so that
+ * scripted entities and asset streaming could be written
+ * linearly instead of hand-rolled state machines.
+ *
+ * The fiber stacks are carved from a pow2 slob allocator
+ * (see gba/mm.h), with the fiber descriptor placed at the
+ * bottom of its stack. The context switch is ARM code in
+ * the internal wram, which saves and loads the callee saved
+ * registers only. So there's no heap activity per switch.
+ *
+ * Fibers are run by the scheduler in round-robin order. A
+ * fiber waiting for interrupts is woken by the interrupt
+ * dispatcher, and the CPU is halted while no fiber is ready.
+ */
+
+// Avoid name mangling when compiled in C++ source.
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// The fiber descriptor, which is opaque to the user.
+typedef struct __gba_fiber __gba_fiber_t;
+
+/// The entry of a fiber, the fiber ends when the entry returns.
+typedef void (*__gba_fiber_entry_t)(void* argument);
+
+/**
+ * @brief Initialize the fiber runtime.
+ *
+ * The page allocator should have been initialized priorly, and the
+ * interrupt master register should be enabled by the user.
+ *
+ * @param stackShift each fiber will have (1 << stackShift) bytes of
+ * stack, including the descriptor. It should be from 8 to 10.
+ * @return zero if the runtime could not be initialized.
+ */
+int __gba_fiber_init(unsigned int stackShift);
+
+/**
+ * @brief Create a fiber, which will be run by the scheduler.
+ *
+ * @return the created fiber, or null if no stack could be allocated.
+ */
+__gba_fiber_t* __gba_fiber_create(__gba_fiber_entry_t entry, void* argument);
+
+/**
+ * @brief Run the scheduler until all fibers have ended. Should be
+ * invoked outside of fibers.
+ */
+void __gba_fiber_run();
+
+/**
+ * @brief Retrieve the running fiber, or null if outside of fibers.
+ */
+__gba_fiber_t* __gba_fiber_self();
+
+/**
+ * @brief Give up the CPU to the other ready fibers.
+ */
+void __gba_fiber_yield();
+
+/**
+ * @brief Suspend the running fiber until one of the interrupts in the
+ * mask (__gba_interrupt_mask_t) is raised. The interrupts will be
+ * enabled, however their sources (e.g. the video status) should be
+ * configured by the user.
+ */
+void __gba_fiber_wait_irq(unsigned short mask);
+
+/**
+ * @brief Suspend the running fiber until next VBlank. The VBlank
+ * interrupt will be enabled in __gba_video_status.
+ */
+void __gba_fiber_wait_vblank();
+
+// End of avoid name mangling when compiled in C++ source.
+#ifdef __cplusplus
+}
+#endif
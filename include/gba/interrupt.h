@@ -11,6 +11,8 @@
  * @see http://problemkaputt.de/gbatek.htm#gbainterruptcontrol
  */
 
+#include <stddef.h>
+
 // Set the memory location alignment to just one.
 #pragma pack(push)
 #pragma pack(1)
@@ -110,6 +112,50 @@ extern volatile __gba_interrupt_t __gba_interrupt_check;
  */
 extern void (*__gba_interrupt_handler)();
 
+/**
+ * The interrupt service which could be attached to the interrupt
+ * dispatcher of the library. Each service will be notified with the
+ * raised interrupts that matches its mask. The node is owned by the
+ * caller and must remain valid while it is attached.
+ *
+ * Unlike the registers, the node holds pointers accessed by words, so it
+ * is laid out with the natural alignment instead of being packed.
+ */
+#pragma pack(push, 4)
+typedef struct __gba_interrupt_service {
+	// The interrupts (__gba_interrupt_mask_t) this service handles.
+	unsigned short mask;
+
+	// Invoked under the interrupt context with the raised interrupts
+	// that matches the mask. Should be compiled with interworking.
+	void (*service)(unsigned short raised);
+
+	// The next service node, maintained by the dispatcher.
+	struct __gba_interrupt_service* next;
+} __gba_interrupt_service_t;
+#pragma pack(pop)
+
+/**
+ * Attach a service to the interrupt dispatcher. The dispatcher will be
+ * installed as the __gba_interrupt_handler, and the interrupts in the
+ * service mask will be enabled. The interrupt master register is left
+ * untouched, and should be enabled by the user.
+ */
+void __gba_interrupt_attach(__gba_interrupt_service_t* service);
+
+/**
+ * Detach a service from the interrupt dispatcher. The interrupts will
+ * remain enabled, but they will not be notified to the service anymore.
+ */
+void __gba_interrupt_detach(__gba_interrupt_service_t* service);
+
+/**
+ * The dispatcher of the library, which acknowledges the raised interrupts,
+ * sets the bits in __gba_interrupt_check (so that BIOS IntrWait works) and
+ * notifies the attached services in the order of attachment.
+ */
+void __gba_interrupt_dispatch();
+
 // End of avoid name mangling when compiled in C++ source.
 #ifdef __cplusplus
 }
@@ -118,6 +164,9 @@ extern void (*__gba_interrupt_handler)();
 // the specified registers.
 static_assert(sizeof(__gba_interrupt_t) == 2,
 	"The structure of GBA keypad should occupy only 2 bytes.");
+static_assert(offsetof(__gba_interrupt_service_t, service) % sizeof(void*) == 0
+	&& offsetof(__gba_interrupt_service_t, next) % sizeof(void*) == 0,
+	"The pointers in the interrupt service node should be word aligned.");
 #endif
 
 // Restore the memory alignment.
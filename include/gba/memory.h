@@ -0,0 +1,92 @@
+#pragma once
+/**
+ * gba/memory.h - Memory primitives for GBA.
+ * @author Haoran Luo
+ *
+ * Defines the memory copying and filling routines. These
+ * routines are written in ARM code and loaded into the
+ * internal working RAM, aligned bodies are transferred in
+ * bursts of 8 registers while the misaligned edges are
+ * handled in halfwords or bytes. Large aligned bodies are
+ * handed off to the BIOS CpuFastSet function.
+ *
+ * The library also defines the memcpy, memmove, memset and
+ * ARM EABI variants as weak aliases of these routines, so
+ * that compiler generated copies could also benefit.
+ *
+ * The VRAM, palette and OAM could not be written in byte,
+ * so the 16-bit variants should be used with them.
+ */
+
+// Avoid name mangling when compiled in C++ source.
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// The routines are in internal working RAM, which could not be
+/// reached by a relative branch from the ROM.
+#ifndef __gba_iwramcall
+#define __gba_iwramcall __attribute__((long_call))
+#endif
+
+/**
+ * Copy a region of memory, which should not overlap.
+ *
+ * @param[in] destination the start of destination region.
+ * @param[in] source the start of source region.
+ * @param[in] size the number of bytes to copy.
+ * @return the destination.
+ */
+void* __gba_memcpy(void* destination,
+	const void* source, unsigned int size) __gba_iwramcall;
+
+/**
+ * Copy a region of memory, which might overlap.
+ *
+ * @param[in] destination the start of destination region.
+ * @param[in] source the start of source region.
+ * @param[in] size the number of bytes to copy.
+ * @return the destination.
+ */
+void* __gba_memmove(void* destination,
+	const void* source, unsigned int size) __gba_iwramcall;
+
+/**
+ * Fill a region of memory with byte.
+ *
+ * @param[in] destination the start of destination region.
+ * @param[in] byte the byte (lower 8 bits) to fill with.
+ * @param[in] size the number of bytes to fill.
+ * @return the destination.
+ */
+void* __gba_memset(void* destination,
+	int byte, unsigned int size) __gba_iwramcall;
+
+/**
+ * Copy a region of memory without writing in byte. Both pointers
+ * should be halfword aligned and the odd byte of size is ignored.
+ *
+ * @param[in] destination the start of destination region.
+ * @param[in] source the start of source region.
+ * @param[in] size the number of bytes to copy.
+ * @return the destination.
+ */
+void* __gba_memcpy16(volatile void* destination,
+	const volatile void* source, unsigned int size) __gba_iwramcall;
+
+/**
+ * Fill a region of memory with halfword. The destination should
+ * be halfword aligned and the odd byte of size is ignored.
+ *
+ * @param[in] destination the start of destination region.
+ * @param[in] halfword the halfword to fill with.
+ * @param[in] size the number of bytes to fill.
+ * @return the destination.
+ */
+void* __gba_memset16(volatile void* destination,
+	unsigned short halfword, unsigned int size) __gba_iwramcall;
+
+// End of avoid name mangling when compiled in C++ source.
+#ifdef __cplusplus
+}
+#endif
@@ -28,9 +28,12 @@ typedef void* __gba_chunk_t;
 typedef unsigned char __gba_bool_t;
 
 /// The eye-candy for defining allocator handles in some region.
-typedef struct { int data[15]; } __gba_page_allocator_t;
-typedef struct { int data[30]; } __gba_malloc_allocator_t;
+typedef struct { int data[20]; } __gba_page_allocator_t;
+typedef struct { int data[5]; } __gba_page_reserve_t;
+typedef struct { int data[80]; } __gba_malloc_allocator_t;
 typedef struct { int type; int data[12]; } __gba_slob_allocator_t;
+typedef struct { int data[6]; } __gba_arena_allocator_t;
+typedef struct { int data[13]; } __gba_arena_pair_t;
 
 /// Could be used to define symbol's trait.
 #ifndef __gba_mmqualifier
@@ -83,6 +86,125 @@ __gba_page_t __gba_pagealloc(__gba_order_t pageOrder) __gba_mmqualifier;
  */
 void __gba_pagefree(__gba_page_t page, __gba_order_t pageOrder) __gba_mmqualifier;
 
+/**
+ * @brief Allocate memory in page unit in bulk.
+ *
+ * A larger block is split once and all its pieces are handed out, which is
+ * faster than allocating the pages one by one.
+ *
+ * @param pageOrder the order of each page to allocate.
+ * @param pages the array to receive the allocated pages.
+ * @param count the number of pages to allocate.
+ * @return the number of pages allocated, which is less than count only if
+ * the memory is exhausted.
+ */
+__gba_size_t __gba_pagealloc_n(__gba_order_t pageOrder, 
+	__gba_page_t* pages, __gba_size_t count) __gba_mmqualifier;
+
+/**
+ * @brief Deallocate memory in page unit in bulk.
+ *
+ * The consecutive pages in the array forming a larger block are returned as
+ * the block, so the pages allocated together had better be deallocated in 
+ * the same order.
+ *
+ * @param pages the array of pages, where the nullptr are skipped.
+ * @param count the number of pages in the array.
+ * @param pageOrder the order of each page while allocating.
+ */
+void __gba_pagefree_n(__gba_page_t* pages, __gba_size_t count, 
+	__gba_order_t pageOrder) __gba_mmqualifier;
+
+/**
+ * @brief Return the cached pages back to the page allocator.
+ *
+ * The recently freed pages of low orders are cached, so that allocating them
+ * again will not split and merge the pages. The cache is drained by itself 
+ * when the pages are exhausted, and could be drained explicitly to reduce 
+ * the fragmentation before allocating large pages.
+ *
+ * @return the number of cached pages returned.
+ */
+__gba_size_t __gba_pagedrain() __gba_mmqualifier;
+
+/**
+ * @brief Shrink the high break point of the page allocator.
+ *
+ * Deallocating a page shrinks the free pages under the high break point 
+ * by a few steps only, so that it is done in constant time. The remained 
+ * free pages could be shrunk in the idle time (like the VBlank), which 
+ * leaves more continguous room for the heap.
+ *
+ * @param budget the maximum steps to perform, each removes a free block.
+ * @return the number of pages shrunk.
+ */
+__gba_size_t __gba_pagetrim(__gba_size_t budget) __gba_mmqualifier;
+
+/**
+ * @brief Reserve pages from the page allocator in advance.
+ *
+ * The pages are pulled out of the page allocator into the reservation owned
+ * by the caller, so that allocating them during the real-time phases will
+ * neither fail nor stall. The reservation is all or nothing, and the previous
+ * reservation in the region must have been released.
+ *
+ * @param reserve the region to initialize the reservation into.
+ * @param pageOrder the order of the reserved pages.
+ * @param count the number of pages to reserve.
+ * @return whether all pages have been reserved.
+ */
+__gba_bool_t __gba_pagereserve(__gba_page_reserve_t* reserve, 
+	__gba_order_t pageOrder, __gba_size_t count) __gba_mmqualifier;
+
+/**
+ * @brief Allocate a page from the reservation in O(1).
+ *
+ * @param reserve the reservation initialized by __gba_pagereserve.
+ * @return the reserved page, or nullptr if the reservation is exhausted.
+ */
+__gba_page_t __gba_pagealloc_reserved(__gba_page_reserve_t* reserve) __gba_mmqualifier;
+
+/**
+ * @brief Deallocate a page back to the reservation in O(1).
+ *
+ * @param reserve the reservation that the page is allocated from.
+ * @param page the page allocated from the reservation.
+ */
+void __gba_pagefree_reserved(__gba_page_reserve_t* reserve, __gba_page_t page) __gba_mmqualifier;
+
+/**
+ * @brief Release the reservation, returning the unused pages back to the page
+ * allocator. The pages in use should be deallocated to the reservation first.
+ *
+ * @param reserve the reservation initialized by __gba_pagereserve.
+ * @return the number of pages returned.
+ */
+__gba_size_t __gba_pagerelease(__gba_page_reserve_t* reserve) __gba_mmqualifier;
+
+/**
+ * @brief Initialize a page allocator managing a span of pages.
+ *
+ * The span of (1 << spanOrder) pages is allocated from the page allocator 
+ * initialized by __gba_pageinit, and the initialized allocator could be 
+ * used to create heaps (see __gba_heap_create). Freeing the span will
+ * drop all memory allocated inside it at once.
+ *
+ * @param allocator the region to initialize the span allocator into.
+ * @param spanOrder request to manage (1 << spanOrder) pages.
+ * @return whether the span has been allocated and initialized.
+ */
+__gba_bool_t __gba_pagespaninit(__gba_page_allocator_t* allocator, __gba_order_t spanOrder) __gba_mmqualifier;
+
+/**
+ * @brief Return the span of pages back to the page allocator.
+ *
+ * All memory allocated from the span, including the heaps created over
+ * it, will be invalidated after the span has been freed.
+ *
+ * @param allocator the span allocator initialized by __gba_pagespaninit.
+ */
+void __gba_pagespanfree(__gba_page_allocator_t* allocator) __gba_mmqualifier;
+
 /**
  * @brief Initialize the dynamic allocation system.
  *
@@ -99,6 +221,10 @@ __gba_bool_t __gba_mallochasinit() __gba_mmqualifier;
 /**
  * @brief Allocate memory as chunk.
  *
+ * The chunks no larger than 64 bytes are firstly allocated from the slob 
+ * caches of size classes (8, 12, 16, 24, 32, 48 and 64 bytes), which have 
+ * no chunk header. The rest are allocated by the dynamic allocation.
+ *
  * @param chunkSize request to allocate (chunkSize) byte of memory.
  * @return the allocated page if success, or nullptr if failed.
  */
@@ -111,11 +237,120 @@ __gba_chunk_t __gba_malloc(__gba_size_t chunkSize) __gba_mmqualifier;
  */
 void __gba_free(__gba_chunk_t chunk) __gba_mmqualifier;
 
+/**
+ * @brief Return the free pages on the top of heap back to the page allocator.
+ *
+ * The top chunk of heap keeps a few free pages after deallocation, so that 
+ * the allocations near the top will not grow and shrink the heap repeatedly.
+ * The pages could be returned explicitly to leave room for allocating pages.
+ *
+ * @param padPages the free pages to keep on the top of heap.
+ * @return the number of pages returned.
+ */
+__gba_size_t __gba_malloctrim(__gba_size_t padPages) __gba_mmqualifier;
+
+/**
+ * @brief Allocate memory as chunk, whose size will be specified again while
+ * deallocating.
+ *
+ * The small chunks are allocated from the slob caches of size classes, which
+ * have no chunk header, and the rest are allocated from the malloc allocator.
+ * The slob caches require the page allocator to be initialized priorly.
+ *
+ * @param chunkSize request to allocate (chunkSize) byte of memory.
+ * @return the allocated chunk if success, or nullptr if failed.
+ */
+__gba_chunk_t __gba_malloc_sized(__gba_size_t chunkSize) __gba_mmqualifier;
+
+/**
+ * @brief Deallocate memory allocated by the sized chunk alloc method.
+ *
+ * With the size specified, the owner of the chunk is known without decoding
+ * the chunk's header. If the size is unknown, 0 could be specified, and the
+ * owner will be decided by decoding the slob frame header of the chunk.
+ *
+ * @param chunk the allocated chunk via sized chunk alloc method.
+ * @param chunkSize the size while allocating, or 0 if unknown.
+ */
+void __gba_free_sized(__gba_chunk_t chunk, __gba_size_t chunkSize) __gba_mmqualifier;
+
+/// The placement hints of the memory allocation.
+enum __gba_mem_hint {
+	// Prefer the zero-wait internal working RAM, for the hot data.
+	memhint_fast = 1 << 0,
+
+	// Prefer the external working RAM, for the large and cold data.
+	memhint_bulk = 1 << 1
+};
+
+/**
+ * @brief Initialize the zone over the unused internal working RAM.
+ *
+ * The zone manages the internal working RAM after the uploaded code and data,
+ * and below the stack reserve under the stack top set by the BIOS (0x03007F00).
+ * Upon success, the zone will be cached for the hinted allocation.
+ *
+ * @param pageAllocator the region to initialize the page allocator of zone.
+ * @param heap the region to initialize the heap of zone.
+ * @param stackReserve the bytes reserved for the user stack.
+ * @return whether the zone has been initialized, or has already been.
+ */
+__gba_bool_t __gba_iwraminit(__gba_page_allocator_t* pageAllocator, 
+	__gba_malloc_allocator_t* heap, __gba_size_t stackReserve) __gba_mmqualifier;
+
+/**
+ * @brief Allocate memory as chunk with a placement hint.
+ *
+ * With memhint_fast, the chunk is allocated from the internal working RAM
+ * zone if possible, and falls back to the malloc allocator otherwise. The 
+ * chunk should be deallocated with the free chunk method.
+ *
+ * @param chunkSize request to allocate (chunkSize) byte of memory.
+ * @param hint the placement hint, see __gba_mem_hint.
+ * @return the allocated chunk if success, or nullptr if failed.
+ */
+__gba_chunk_t __gba_malloc_hint(__gba_size_t chunkSize, int hint) __gba_mmqualifier;
+
+/**
+ * @brief Create an independent heap over a page allocator.
+ *
+ * Unlike the malloc allocator, the heap is not cached, and the allocation
+ * and deallocation should specify the heap. The page allocator is usually
+ * a span (see __gba_pagespaninit), so that the heap could be dropped 
+ * wholesale by freeing the span. The page allocator should not be shared 
+ * with the malloc allocator or other heaps.
+ *
+ * @param pageAllocator the initialized page allocator.
+ * @param heap the region to initialize the heap into.
+ * @return whether the heap has been created.
+ */
+__gba_bool_t __gba_heap_create(__gba_page_allocator_t* pageAllocator, __gba_malloc_allocator_t* heap) __gba_mmqualifier;
+
+/**
+ * @brief Allocate memory as chunk from a heap.
+ *
+ * @param heap the heap created by __gba_heap_create.
+ * @param chunkSize request to allocate (chunkSize) byte of memory.
+ * @return the allocated chunk if success, or nullptr if failed.
+ */
+__gba_chunk_t __gba_heap_malloc(__gba_malloc_allocator_t* heap, __gba_size_t chunkSize) __gba_mmqualifier;
+
+/**
+ * @brief Deallocate memory to the heap it is allocated from.
+ *
+ * @param heap the heap created by __gba_heap_create.
+ * @param chunk the allocated chunk via heap malloc method.
+ */
+void __gba_heap_free(__gba_malloc_allocator_t* heap, __gba_chunk_t chunk) __gba_mmqualifier;
+
 /**
  * @brief Initialize a slob allocator, with object size.
  *
  * Objects allocated will be of the same size. And if the allocation has succeeded,
  * true will be returned, otherwise false will be returned.
+ *
+ * The slob frames span multiple pages as the pool grows, so that the larger pools
+ * take fewer frames and waste less space in each frame.
  */
 __gba_bool_t __gba_slobinit(__gba_slob_allocator_t* allocator, __gba_size_t chunkSize) __gba_mmqualifier;
 
@@ -139,8 +374,217 @@ __gba_chunk_t __gba_sloballoc(__gba_slob_allocator_t* allocator) __gba_mmqualifi
  *
  * @param allocator the slob allocator.
  * @param chunk the expected slob chunk.
+ * @return false if the chunk is not in any slob frame of the allocator, 
+ * which leaves the allocator unchanged.
+ */
+__gba_bool_t __gba_slobfree(__gba_slob_allocator_t* allocator, __gba_chunk_t chunk) __gba_mmqualifier;
+
+/**
+ * @brief Allocate slobs in bulk from the slob allocator.
+ *
+ * The slobs are filled from one slob frame at a time, which is faster than 
+ * allocating them one by one.
+ *
+ * @param allocator the slob allocator.
+ * @param chunks the array to receive the allocated slobs.
+ * @param count the number of slobs to allocate.
+ * @return the number of slobs allocated, which is less than count only if
+ * the memory is exhausted.
+ */
+__gba_size_t __gba_sloballoc_n(__gba_slob_allocator_t* allocator, 
+	__gba_chunk_t* chunks, __gba_size_t count) __gba_mmqualifier;
+
+/**
+ * @brief Deallocate slobs in bulk to the slob allocator.
+ *
+ * The consecutive slobs of the same slob frame are returned together, so the
+ * slobs allocated together had better be deallocated in the same order.
+ *
+ * @param allocator the slob allocator.
+ * @param chunks the array of slobs, where the nullptr are skipped.
+ * @param count the number of slobs in the array.
+ * @return the number of slobs deallocated, excluding the nullptr and the
+ * slobs not in any slob frame of the allocator.
+ */
+__gba_size_t __gba_slobfree_n(__gba_slob_allocator_t* allocator, 
+	__gba_chunk_t* chunks, __gba_size_t count) __gba_mmqualifier;
+
+/**
+ * @brief Set the watermarks of the free slob frames retained by the allocator.
+ *
+ * The emptied slob frames are retained for later allocation, rather than 
+ * deallocated to the page allocator at once. Once the retained frames exceed
+ * the high watermark, they will be deallocated until reaching the low one.
+ * By default, no frame is retained.
+ *
+ * @param allocator the slob allocator.
+ * @param low the low watermark, which is clamped to the high one.
+ * @param high the high watermark.
+ */
+void __gba_slobretain(__gba_slob_allocator_t* allocator, 
+	__gba_size_t low, __gba_size_t high) __gba_mmqualifier;
+
+/**
+ * @brief Deallocate all free slob frames retained by the allocator.
+ *
+ * @param allocator the slob allocator.
+ * @return the number of slob frames deallocated.
+ */
+__gba_size_t __gba_slobshrink(__gba_slob_allocator_t* allocator) __gba_mmqualifier;
+
+/**
+ * @brief Initialize an arena allocator, with the order of its blocks.
+ *
+ * The arena allocates objects by bumping a cursor inside the blocks allocated
+ * from the page allocator, which suits the data discarded all at once, like
+ * the per-frame data. If the initialization has succeeded, true will be 
+ * returned, otherwise false will be returned.
+ */
+__gba_bool_t __gba_arenainit(__gba_arena_allocator_t* allocator, __gba_order_t blockOrder) __gba_mmqualifier;
+
+/**
+ * @brief Allocate an object from the arena allocator.
+ *
+ * @param allocator the arena allocator.
+ * @param chunkSize request to allocate (chunkSize) byte of memory.
+ * @param alignment the alignment of the object, which must be power of 2.
+ * @return the allocated object or nullptr if cannot allocate.
+ */
+__gba_chunk_t __gba_arenaalloc(__gba_arena_allocator_t* allocator, 
+	__gba_size_t chunkSize, __gba_size_t alignment) __gba_mmqualifier;
+
+/**
+ * @brief Discard all objects in the arena allocator in O(1), while its blocks
+ * are kept for further allocation.
  */
-void __gba_slobfree(__gba_slob_allocator_t* allocator, __gba_chunk_t chunk) __gba_mmqualifier;
+void __gba_arenareset(__gba_arena_allocator_t* allocator) __gba_mmqualifier;
+
+/**
+ * @brief Discard all objects in the arena allocator and return its blocks back
+ * to the page allocator.
+ */
+void __gba_arenarelease(__gba_arena_allocator_t* allocator) __gba_mmqualifier;
+
+/**
+ * @brief Initialize a pair of arena allocators used in ping-pong manner, for
+ * the data living for two frames.
+ */
+__gba_bool_t __gba_arenapairinit(__gba_arena_pair_t* pair, __gba_order_t blockOrder) __gba_mmqualifier;
+
+/**
+ * @brief Allocate an object from the front arena of the pair.
+ */
+__gba_chunk_t __gba_arenapairalloc(__gba_arena_pair_t* pair, 
+	__gba_size_t chunkSize, __gba_size_t alignment) __gba_mmqualifier;
+
+/**
+ * @brief Flip the pair at the start of a frame. The objects allocated two 
+ * frames ago are discarded, and the ones allocated last frame remains.
+ */
+void __gba_arenapairflip(__gba_arena_pair_t* pair) __gba_mmqualifier;
+
+/**
+ * @brief Return the blocks of both arenas back to the page allocator.
+ */
+void __gba_arenapairrelease(__gba_arena_pair_t* pair) __gba_mmqualifier;
+
+/**
+ * @brief The interrupt safe flavour of the allocation methods.
+ *
+ * The allocators are shared between the main loop and the interrupt 
+ * handlers, so once a handler allocates, both sides should allocate with 
+ * these flavours. The interrupts are masked via the master register for 
+ * the whole call, and the master register will be restored afterwards, so
+ * they could also be invoked inside handlers.
+ *
+ * The methods without such flavour, which initialize, trim, drain, shrink,
+ * release, reset or flip the allocators, and retrieve their statistics, 
+ * are for the main loop only, and should not be invoked while a handler
+ * might allocate from the same allocator.
+ */
+__gba_page_t __gba_pagealloc_irqsafe(__gba_order_t pageOrder) __gba_mmqualifier;
+void __gba_pagefree_irqsafe(__gba_page_t page, __gba_order_t pageOrder) __gba_mmqualifier;
+__gba_page_t __gba_pagealloc_reserved_irqsafe(__gba_page_reserve_t* reserve) __gba_mmqualifier;
+void __gba_pagefree_reserved_irqsafe(__gba_page_reserve_t* reserve, __gba_page_t page) __gba_mmqualifier;
+__gba_chunk_t __gba_malloc_irqsafe(__gba_size_t chunkSize) __gba_mmqualifier;
+void __gba_free_irqsafe(__gba_chunk_t chunk) __gba_mmqualifier;
+__gba_chunk_t __gba_malloc_sized_irqsafe(__gba_size_t chunkSize) __gba_mmqualifier;
+void __gba_free_sized_irqsafe(__gba_chunk_t chunk, __gba_size_t chunkSize) __gba_mmqualifier;
+__gba_chunk_t __gba_heap_malloc_irqsafe(__gba_malloc_allocator_t* heap, __gba_size_t chunkSize) __gba_mmqualifier;
+void __gba_heap_free_irqsafe(__gba_malloc_allocator_t* heap, __gba_chunk_t chunk) __gba_mmqualifier;
+__gba_chunk_t __gba_sloballoc_irqsafe(__gba_slob_allocator_t* allocator) __gba_mmqualifier;
+__gba_bool_t __gba_slobfree_irqsafe(__gba_slob_allocator_t* allocator, __gba_chunk_t chunk) __gba_mmqualifier;
+__gba_size_t __gba_sloballoc_n_irqsafe(__gba_slob_allocator_t* allocator, 
+	__gba_chunk_t* chunks, __gba_size_t count) __gba_mmqualifier;
+__gba_size_t __gba_slobfree_n_irqsafe(__gba_slob_allocator_t* allocator, 
+	__gba_chunk_t* chunks, __gba_size_t count) __gba_mmqualifier;
+__gba_chunk_t __gba_arenaalloc_irqsafe(__gba_arena_allocator_t* allocator, 
+	__gba_size_t chunkSize, __gba_size_t alignment) __gba_mmqualifier;
+
+/// The statistics of the page allocator.
+typedef struct {
+	/// The total pages, and the pages below the low and high break points.
+	__gba_size_t totalPages, lowBreak, highBreak;
+	
+	/// The peak of the pages below both break points.
+	__gba_size_t peakBreak;
+	
+	/// The recently freed pages cached for reuse, which are regarded in use.
+	__gba_size_t cachedPages;
+	
+	/// The free blocks of each order between the break points, and the pages 
+	/// they hold. The orders above the maximum order are always 0.
+	__gba_size_t freeBlocks[8], freePages;
+} __gba_pagestat_t;
+
+/// The statistics of the malloc allocator (or a heap).
+typedef struct {
+	/// The bytes below the low break point, and the bytes of the top chunk.
+	__gba_size_t heapBytes, topBytes;
+	
+	/// The bytes of allocated chunks including their headers, and the peak.
+	__gba_size_t inUseBytes, peakBytes;
+	
+	/// The free chunks and their bytes in each kind of bin.
+	__gba_size_t smallChunks, smallBytes;
+	__gba_size_t largeChunks, largeBytes;
+	__gba_size_t unsortedChunks, unsortedBytes;
+	
+	/// The largest free chunk in the bins, excluding the top chunk.
+	__gba_size_t largestFreeChunk;
+} __gba_mallinfo_t;
+
+/// The statistics of the slob allocator.
+typedef struct {
+	/// The frames which are full, partial and retained free.
+	__gba_size_t fullFrames, partialFrames, freeFrames;
+	
+	/// The objects in use, the objects the frames could hold, and the peak.
+	__gba_size_t usedObjects, capacityObjects, peakObjects;
+} __gba_slobstat_t;
+
+/**
+ * @brief The statistics and fragmentation introspection.
+ *
+ * The queries walk the free lists, so they are meant for debugging and 
+ * profiling rather than every frame. Both the library and the application
+ * should be built with __gba_mmstat defined to collect the statistics.
+ * Otherwise the queries compile to nothing and always fail.
+ *
+ * @param allocator the allocator to query, where nullptr refers to the 
+ * cached page allocator or malloc allocator.
+ * @param stat the structure to receive the statistics.
+ * @return whether the statistics have been retrieved.
+ */
+#ifdef __gba_mmstat
+__gba_bool_t __gba_pagestat(__gba_page_allocator_t* allocator, __gba_pagestat_t* stat) __gba_mmqualifier;
+__gba_bool_t __gba_mallinfo(__gba_malloc_allocator_t* allocator, __gba_mallinfo_t* stat) __gba_mmqualifier;
+__gba_bool_t __gba_slobstat(__gba_slob_allocator_t* allocator, __gba_slobstat_t* stat) __gba_mmqualifier;
+#else
+#define __gba_pagestat(allocator, stat) ((__gba_bool_t)0)
+#define __gba_mallinfo(allocator, stat) ((__gba_bool_t)0)
+#define __gba_slobstat(allocator, stat) ((__gba_bool_t)0)
+#endif
  
 // End of enforcing c symbol.
 #ifdef __cplusplus
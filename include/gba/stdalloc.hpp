@@ -0,0 +1,75 @@
+#pragma once
+/**
+ * @file gba/stdalloc.hpp
+ * @brief Standard Library Allocators for GBA
+ * @author Haoran Luo
+ *
+ * Defines the backends of the standard library allocator adapter (see
+ * gmlibc/stdalloc.hpp) over the memory management in gba/mm.h, so that
+ * the containers could allocate from the malloc allocator, the slob
+ * caches of size classes and the arena allocators.
+ *
+ * The backends require the corresponding allocators to be initialized
+ * priorly, otherwise the allocation will fail. The malloc and sized
+ * backends only guarantee the word alignment, so the allocation of the
+ * types aligned beyond a word will fail instead of being misaligned.
+ */
+#include "gba/mm.h"
+#include "gmlibc/stdalloc.hpp"
+
+/// The backend allocating from the malloc allocator.
+struct __gba_malloc_backend {
+	static constexpr __gba_size_t maxAlignment = 4;
+
+	void* allocate(__gba_size_t size, __gba_size_t alignment) noexcept {
+		if(alignment > maxAlignment) return nullptr;
+		return __gba_malloc(size);
+	}
+
+	void deallocate(void* memory, __gba_size_t) noexcept {
+		__gba_free(memory);
+	}
+
+	bool operator==(const __gba_malloc_backend&) const noexcept { return true; }
+};
+
+/// The backend allocating from the slob caches of size classes, with the
+/// size specified while deallocating. Suits the node based containers.
+struct __gba_sized_backend {
+	static constexpr __gba_size_t maxAlignment = 4;
+
+	void* allocate(__gba_size_t size, __gba_size_t alignment) noexcept {
+		if(alignment > maxAlignment) return nullptr;
+		return __gba_malloc_sized(size);
+	}
+
+	void deallocate(void* memory, __gba_size_t size) noexcept {
+		__gba_free_sized(memory, size);
+	}
+
+	bool operator==(const __gba_sized_backend&) const noexcept { return true; }
+};
+
+/// The backend allocating from an arena allocator. The memory is discarded
+/// with the arena, so deallocation does nothing.
+struct __gba_arena_backend {
+	__gba_arena_allocator_t* arena;
+
+	__gba_arena_backend() noexcept: arena(nullptr) {}
+	__gba_arena_backend(__gba_arena_allocator_t* arena) noexcept: arena(arena) {}
+
+	void* allocate(__gba_size_t size, __gba_size_t alignment) noexcept {
+		return __gba_arenaalloc(arena, size, alignment);
+	}
+
+	void deallocate(void*, __gba_size_t) noexcept {}
+
+	bool operator==(const __gba_arena_backend& other) const noexcept {
+		return arena == other.arena;
+	}
+};
+
+/// The allocators that could be passed to the containers.
+template<typename T> using __gba_malloc_stdalloc = GmOsStdAllocator<T, __gba_malloc_backend>;
+template<typename T> using __gba_sized_stdalloc = GmOsStdAllocator<T, __gba_sized_backend>;
+template<typename T> using __gba_arena_stdalloc = GmOsStdAllocator<T, __gba_arena_backend>;
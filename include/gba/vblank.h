@@ -0,0 +1,84 @@
+#pragma once
+/**
+ * gba/vblank.h - VBlank deferred work queue for GBA.
+ * @author Haoran Luo
+ *
+ * Defines the queue of works that should be done during
+ * VBlank, like updating VRAM, OAM and palette. The works
+ * are run by the VBlank interrupt service in the order of
+ * priority, until the remained VBlank time could not hold
+ * the estimated cost of next work. The rest will be carried
+ * to the next frame, so that updates neither tear nor leave
+ * the VBlank time unused.
+ *
+ * @see http://problemkaputt.de/gbatek.htm#lcddimensionsandtimings
+ */
+
+// Avoid name mangling when compiled in C++ source.
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// The number of cycles for a scanline, and for the VBlank period.
+#define __gba_vblank_linecycles 1232
+#define __gba_vblank_cycles 83776
+
+/// The number of priorities, where 0 is the highest priority.
+#define __gba_vblank_priorities 4
+
+/**
+ * The deferred work, which is owned by the caller and must remain valid
+ * until it has been run. The work must be zero initialized before it is
+ * enqueued for the first time.
+ */
+typedef struct __gba_vblank_work {
+	// Invoked with the context under the interrupt context.
+	void (*work)(void* context);
+	void* context;
+
+	// The estimated cost of this work in cycles.
+	unsigned int cost;
+
+	// The priority of this work, lower than __gba_vblank_priorities.
+	unsigned char priority;
+
+	// Whether the work is in queue, maintained by the queue.
+	unsigned char queued;
+
+	// The next work in queue, maintained by the queue.
+	struct __gba_vblank_work* next;
+} __gba_vblank_work_t;
+
+/**
+ * @brief Initialize the VBlank work queue.
+ *
+ * The queue attaches itself to the interrupt dispatcher and enables the
+ * VBlank interrupt in __gba_video_status. Services attached before the
+ * queue (like the scanline tables) will be notified before the works run.
+ */
+void __gba_vblank_init();
+
+/**
+ * @brief Enqueue a work to be run in the VBlank period.
+ *
+ * Works of the same priority are run in the order of enqueuing. The first
+ * work of each VBlank period is always run, so a work whose cost exceeds
+ * the whole VBlank period will be run alone instead of being blocked.
+ * A work enqueued while the works are running (like a work enqueuing 
+ * itself again) will be run in the next VBlank period, whatever its
+ * priority is.
+ *
+ * @return zero if the work is invalid or already in queue, otherwise 
+ * non-zero.
+ */
+int __gba_vblank_enqueue(__gba_vblank_work_t* work);
+
+/**
+ * @brief Retrieve the number of works pending in the queue.
+ */
+unsigned int __gba_vblank_pending();
+
+// End of avoid name mangling when compiled in C++ source.
+#ifdef __cplusplus
+}
+#endif
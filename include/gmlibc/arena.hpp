@@ -0,0 +1,213 @@
+#pragma once
+/**
+ * @file gmlibc/arena.hpp
+ * @brief Bump Pointer Arena Fine Allocator
+ * @author Haoran Luo
+ *
+ * This allocator suits the data whose lifetime is bound to a period (like a
+ * frame), which could be discarded all at once at the end of the period.
+ *
+ * The arena keeps a list of blocks allocated from the high pages of the page
+ * allocator. Allocation just bumps the cursor inside the current block, and
+ * moves on to the next block once the current one could not hold the request.
+ * Objects could not be deallocated individually, but the whole arena could be
+ * reset in O(1), which rewinds the cursor to the first block while keeping the
+ * blocks for the next period.
+ *
+ * Arena Descriptor                     Arena Block
+ * +--------------+                     +-----------------+
+ * | Head         | ------------------> | Next            | --> Next Block
+ * +--------------+                     +-----------------+
+ * | Current      |                     | Order           |
+ * +--------------+                     +-----------------+
+ * | Cursor       | ----+               | Objects...      |
+ * +--------------+     +-------------> | ----------------|
+ * | Limit        |                     | Unused...       |
+ * +--------------+                     +-----------------+
+ */
+
+/**
+ * The concept of an arena allocator's information, which is a subset of the
+ * buddy page allocator's information.
+ *
+ * concept arenaInfo {
+ *     // The type of the order.
+ *     typedef <orderType> orderType;
+ *
+ *     // The maximum order of the page allocator.
+ *     static constexpr orderType maxPageOrder;
+ *
+ *     // The page size of the page allocator, in the unit of shift.
+ *     static constexpr orderType pageSizeShift;
+ *
+ *     // The type of the physical address type using as integer.
+ *     typedef <addressType> addressType;
+ *
+ *     // The type of the allocation size.
+ *     typedef <allocateSizeType> allocateSizeType;
+ *
+ *     // The pointer indicating the null pages.
+ *     static const addressType nullPageAddress;
+ * };
+ */
+
+template<typename arenaInfo, typename pageAllocatorType>
+struct GmOsFineAllocatorArena {
+	/// Forward template types ahead.
+	typedef typename arenaInfo::orderType orderType;
+	typedef typename arenaInfo::addressType addressType;
+	typedef typename arenaInfo::allocateSizeType allocateSizeType;
+	typedef typename pageAllocatorType::pageType pageType;
+
+	/// The header of the arena block, and the objects goes after the header.
+	struct GmOsArenaBlock {
+		/// The next block in the arena.
+		GmOsArenaBlock* next;
+
+		/// The page order of this block.
+		orderType order;
+
+		/// Retrieve the address of the first object.
+		inline addressType base() const noexcept {
+			return reinterpret_cast<addressType>(this) + sizeof(GmOsArenaBlock);
+		}
+
+		/// Retrieve the address right after the last object.
+		inline addressType limit() const noexcept {
+			return reinterpret_cast<addressType>(this)
+				+ ((1 << arenaInfo::pageSizeShift) << order);
+		}
+	};
+	typedef GmOsArenaBlock* blockType;
+
+	/// The page allocator which the arena relies on.
+	pageAllocatorType& pageAllocator;
+
+	/// The first block and the block being bumped.
+	blockType head, current;
+
+	/// The cursor and limit of the current block.
+	addressType cursor, limit;
+
+	/// The page order of the blocks, except for the oversized requests.
+	orderType blockOrder;
+
+	/// Constructor for the arena class.
+	GmOsFineAllocatorArena(pageAllocatorType& pageAllocator, orderType blockOrder) noexcept:
+		pageAllocator(pageAllocator), head(nullptr), current(nullptr),
+		cursor(0), limit(0), blockOrder(blockOrder) {}
+
+	/// Align the address up to the alignment, which must be power of 2.
+	static inline addressType alignUp(addressType address, allocateSizeType alignment) noexcept {
+		return (address + (alignment - 1)) & ~((addressType)alignment - 1);
+	}
+
+	/// Make the block the current block being bumped.
+	inline void enterBlock(blockType block) noexcept {
+		current = block;
+		cursor = block -> base();
+		limit = block -> limit();
+	}
+
+	/// Attempt to bump the object inside current block.
+	inline void* bump(allocateSizeType size, allocateSizeType alignment) noexcept {
+		addressType result = alignUp(cursor, alignment);
+		if(result > limit || size > (allocateSizeType)(limit - result)) return nullptr;
+		cursor = result + size;
+		return reinterpret_cast<void*>(result);
+	}
+
+	/// Allocate an object with specified alignment. If no more block could be
+	/// allocated, the null pointer will be returned.
+	void* allocate(allocateSizeType size, allocateSizeType alignment) noexcept {
+		if(alignment == 0 || (alignment & (alignment - 1)) != 0) return nullptr;
+
+		// Bump the object inside the current block.
+		if(current != nullptr) {
+			void* result = bump(size, alignment);
+			if(result != nullptr) return result;
+		}
+
+		// Move on to the retained blocks after current block.
+		while(current != nullptr && current -> next != nullptr) {
+			enterBlock(current -> next);
+			void* result = bump(size, alignment);
+			if(result != nullptr) return result;
+		}
+
+		// Find the order of block to hold the object, in the worst alignment.
+		allocateSizeType required = sizeof(GmOsArenaBlock) + size + (alignment - 1);
+		if(required < size) return nullptr;
+		orderType order = blockOrder;
+		for(; order < arenaInfo::maxPageOrder && ((allocateSizeType)
+			(1 << arenaInfo::pageSizeShift) << order) < required; ++ order);
+		if(order >= arenaInfo::maxPageOrder) return nullptr;
+
+		// Allocate a new block and append it to the arena.
+		pageType page = pageAllocator.allocateHighPage(order);
+		if(page == (pageType)arenaInfo::nullPageAddress) return nullptr;
+		blockType block = reinterpret_cast<blockType>(page);
+		block -> next = nullptr;
+		block -> order = order;
+		if(current == nullptr) head = block;
+		else current -> next = block;
+		enterBlock(block);
+		return bump(size, alignment);
+	}
+
+	/// Discard all objects allocated in the arena, while the blocks are kept.
+	void reset() noexcept {
+		if(head == nullptr) return;
+		enterBlock(head);
+	}
+
+	/// Discard all objects allocated and return the blocks to the page allocator.
+	void release() noexcept {
+		while(head != nullptr) {
+			blockType block = head;
+			head = block -> next;
+			pageAllocator.freeHighPage(reinterpret_cast<pageType>(block), block -> order);
+		}
+		current = nullptr;
+		cursor = limit = 0;
+	}
+};
+
+/**
+ * The pair of arenas used in ping-pong manner, for the data living for two
+ * periods. Flipping the pair resets the arena used two periods ago and then
+ * allocates from it, while the objects allocated in the last period remains.
+ */
+template<typename arenaType>
+struct GmOsFineAllocatorArenaPair {
+	/// Forward template types ahead.
+	typedef typename arenaType::orderType orderType;
+	typedef typename arenaType::allocateSizeType allocateSizeType;
+
+	/// The arenas and the arena being allocated from.
+	arenaType arenas[2];
+	unsigned char front;
+
+	/// Constructor for the arena pair class.
+	template<typename pageAllocatorType>
+	GmOsFineAllocatorArenaPair(pageAllocatorType& pageAllocator, orderType blockOrder) noexcept:
+		arenas{arenaType(pageAllocator, blockOrder), arenaType(pageAllocator, blockOrder)},
+		front(0) {}
+
+	/// Allocate an object from the front arena.
+	inline void* allocate(allocateSizeType size, allocateSizeType alignment) noexcept {
+		return arenas[front].allocate(size, alignment);
+	}
+
+	/// Start a new period, making the back arena the front one.
+	void flip() noexcept {
+		front ^= 1;
+		arenas[front].reset();
+	}
+
+	/// Return the blocks of both arenas to the page allocator.
+	void release() noexcept {
+		arenas[0].release();
+		arenas[1].release();
+	}
+};
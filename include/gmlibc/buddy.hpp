@@ -23,26 +23,22 @@
  *     // The maximum order of the buddy allocator.
  *     static constexpr orderType maxPageOrder;
  *
- *     // The type of the page frame number.
- *     typedef <pageSizeType> pfnType;
- *
- *     // The size of bitmap that will be used by the allocator.
- *     static constexpr pfnType bitmapTotalSize;
- *
- *     // The offset of each order in bitmap.
- *     static pfnType bitmapOrderOffset[maxPageOrder];
- *
  *     // The page size of the allocator, in the unit of shift.
  *     static constexpr orderType pageSizeShift;
  *
  *     // The type of the physical address type using as integer.
  *     typedef <addressType> addressType;
  *
- *     // The total count of allocatable page frame count.
- *     static pfnType totalPageFrame() noexcept;
+ *     // The size of the largest region that the allocator could manage. The type of
+ *     // page frame number and the bitmap layout are derived from it at compile time.
+ *     static constexpr addressType regionSize;
+ *
+ *     // The total count of allocatable page frame count, which must not exceed the
+ *     // page frames in region size. Used as the default geometry of the allocator.
+ *     static addressType totalPageFrame() noexcept;
  *
  *     // Retrieve the start address of the first page, it might be static and calcualte
- *     // from other external symbols.
+ *     // from other external symbols. Used as the default geometry of the allocator.
  *     static addressType firstPageAddress() noexcept;
  *
  *     // The pointer indicating the null pages.
@@ -60,16 +56,61 @@
  *     // recommended to turn off if the application is always expect to use not so 
  *     // much page.
  *     static const bool deftHighBreakShrink;
+ *
+ *     // How many free blocks under the high break point could be shrunk by one 
+ *     // deallocation, which bounds its worst case. The remained ones are shrunk by 
+ *     // trimming explicitly (e.g. in idle time), or when the low pages run out.
+ *     static constexpr orderType highBreakShrinkSteps;
+ *
+ *     // The orders below it will cache the recently freed pages, bypassing merging
+ *     // and splitting. Set it to 0 to disable the cache.
+ *     static constexpr orderType hotPageOrders;
+ *
+ *     // How many recently freed pages could be cached for each order.
+ *     static constexpr orderType hotPageDepth;
+ *
+ *     // Should the allocator record the peak of its break points. The counter is
+ *     // compiled to nothing if not.
+ *     static constexpr bool collectStatistics;
  * };
  */
+#include "gmlibc/counter.hpp"
+
+/// Select the narrowest unsigned type holding the page frame numbers.
+template<bool fitsChar, bool fitsShort> struct GmOsPageFrameNumberSelect { typedef unsigned int type; };
+template<bool fitsShort> struct GmOsPageFrameNumberSelect<true, fitsShort> { typedef unsigned char type; };
+template<> struct GmOsPageFrameNumberSelect<false, true> { typedef unsigned short type; };
 
 template<typename buddyInfo>
 struct GmOsPageAllocatorBuddy {
 	/// Forward template types ahead.
 	typedef typename buddyInfo::orderType orderType;
-	typedef typename buddyInfo::pfnType pfnType;
 	typedef typename buddyInfo::addressType addressType;
 	
+	/// The maximum count of page frames in the region, rounded up to the blocks of
+	/// maximum order so that every order's bitmap is exactly half of the previous.
+	static constexpr addressType maxBlockFrame = 1 << (buddyInfo::maxPageOrder - 1);
+	static constexpr addressType maxPageFrame = ((buddyInfo::regionSize >> buddyInfo::pageSizeShift)
+			+ maxBlockFrame - 1) / maxBlockFrame * maxBlockFrame;
+	static_assert(maxPageFrame > 0, "The region could not hold a page.");
+	
+	/// The page frame number's type, which holds the page frame numbers and the high
+	/// break point while growing by a block of maximum order.
+	static constexpr addressType maxPageFrameNumber = maxPageFrame + (1 << buddyInfo::maxPageOrder);
+	typedef typename GmOsPageFrameNumberSelect<(maxPageFrameNumber <= 0xff),
+			(maxPageFrameNumber <= 0xffff)>::type pfnType;
+	
+	/// The bitmap of each order follows the one of previous order, and the order n 
+	/// holds (maxPageFrame >> n) bits. So the offset of order n is the geometric sum 
+	/// (2 * maxPageFrame - (2 * maxPageFrame >> n)), which is resolved by shifting 
+	/// an immediate instead of loading from a table.
+	typedef unsigned int bitIndexType;
+	static constexpr bitIndexType bitmapSpan = maxPageFrame << 1;
+	static constexpr bitIndexType bitmapOrderOffset(orderType order) noexcept {
+		return bitmapSpan - (bitmapSpan >> order);
+	}
+	static constexpr bitIndexType bitmapTotalSize = (bitmapOrderOffset(buddyInfo::maxPageOrder) + 7) >> 3;
+	
 	/// Represents a buddy page in the memory.
 	union GmOsPageBuddy {
 		/// The link list nodes in the managed body.
@@ -89,26 +130,45 @@ struct GmOsPageAllocatorBuddy {
 	/// Forward the definition of the page type.
 	typedef GmOsPageBuddy* pageType;
 	
+	/// Retrieve the start address of the first page managed by this allocator.
+	inline addressType firstPageAddress() const noexcept { return pageBase; }
+	
+	/// Retrieve the total count of page frames managed by this allocator.
+	inline pfnType totalPageFrame() const noexcept { return pageCount; }
+	
 	/// Calculate the page frame number of a page. Please notice the page counting is 
 	/// reversed, which means the page at the start is totalPageFrame - 1, and the 
 	/// page at the end is 0.
-	static pfnType pageFrameFor(const pageType page) noexcept {
+	pfnType pageFrameFor(const pageType page) const noexcept {
 		pfnType reversePageFrame = (reinterpret_cast<addressType>(page) 
-				- buddyInfo::firstPageAddress()) >> buddyInfo::pageSizeShift;
-		return buddyInfo::totalPageFrame() - 1 - reversePageFrame;
+				- firstPageAddress()) >> buddyInfo::pageSizeShift;
+		return totalPageFrame() - 1 - reversePageFrame;
 	}
 	
 	/// Calculate the page address from a frame.
-	static pageType pageFrameFrom(pfnType pfn) noexcept {
-		return reinterpret_cast<pageType>(((buddyInfo::totalPageFrame() - 1 - pfn) 
-			<< buddyInfo::pageSizeShift) + buddyInfo::firstPageAddress());
+	pageType pageFrameFrom(pfnType pfn) const noexcept {
+		return reinterpret_cast<pageType>(((totalPageFrame() - 1 - pfn) 
+			<< buddyInfo::pageSizeShift) + firstPageAddress());
+	}
+	
+	/// Calculate the lowest address of a block of pages, whose first page frame number
+	/// is the specified one. As the page counting is reversed, the block's first page 
+	/// frame is at the highest address of the block.
+	pageType blockAddressOf(pfnType pfn, orderType order) const noexcept {
+		return pageFrameFrom(pfn + (1 << order) - 1);
+	}
+	
+	/// Calculate the first page frame number of a block of pages from its lowest address.
+	pfnType blockFrameOf(const pageType page, orderType order) const noexcept {
+		return pageFrameFor(page) - ((1 << order) - 1);
 	}
 	
 	/// Calculate offset and index from page frame number.
-	static inline void indexFrom(pfnType pfn, orderType order, pfnType& index, pfnType& offset) noexcept {
-		pfnType pfnIndex = pfn >> order;
-		index  = (buddyInfo::bitmapOrderOffset[order] + pfnIndex) >> 3;
-		offset = (buddyInfo::bitmapOrderOffset[order] + pfnIndex) & 0x07;
+	static inline void indexFrom(pfnType pfn, orderType order, 
+		bitIndexType& index, bitIndexType& offset) noexcept {
+		bitIndexType bitIndex = bitmapOrderOffset(order) + (pfn >> order);
+		index  = bitIndex >> 3;
+		offset = bitIndex & 0x07;
 	}
 	
 	/// Unlink a page from the free list. Unsetting bitmap's bit is not included here.
@@ -128,18 +188,18 @@ struct GmOsPageAllocatorBuddy {
 	}
 	
 	/// Set the bitmap by index and offset.
-	inline void bitmapSet(pfnType index, pfnType offset) noexcept {
+	inline void bitmapSet(bitIndexType index, bitIndexType offset) noexcept {
 		bitmap[index] |= (1 << offset);
 	}
 	
 	/// Clear the bitmap by index and offset.
-	inline void bitmapClear(pfnType index, pfnType offset) noexcept {
+	inline void bitmapClear(bitIndexType index, bitIndexType offset) noexcept {
 		char bit = (1 << offset);
 		bitmap[index] = (bitmap[index] | bit) ^ bit;
 	}
 	
 	/// Check whether a bitmap bit is set.
-	inline bool bitmapHas(pfnType index, pfnType offset) const noexcept {
+	inline bool bitmapHas(bitIndexType index, bitIndexType offset) const noexcept {
 		return (bitmap[index] & (1 << offset)) != 0;
 	}
 	
@@ -149,6 +209,13 @@ struct GmOsPageAllocatorBuddy {
 	/// The break point of the slab / high page allocation.
 	pfnType hpbrk;
 	
+	/// The total count of page frames managed by this allocator.
+	pfnType pageCount;
+	
+	/// The peak of the page frames below both break points, which is empty and
+	/// fits in the padding when the statistics are not collected.
+	GmOsUsageCounter<pfnType, buddyInfo::collectStatistics> pageUsage;
+	
 	/// The list of free pages in different orders. Please notice the page of higher 
 	/// address always come earlier in the free page list. Should all be initially
 	/// null page pointer.
@@ -156,54 +223,126 @@ struct GmOsPageAllocatorBuddy {
 	
 	/// The bitmap recording the pages status. If a page is inside free list, it will be 
 	/// marked 1. This field MUST be initially 0, and it should be cleared somewhere.
-	char bitmap[buddyInfo::bitmapTotalSize];
+	char bitmap[bitmapTotalSize];
 	static_assert(sizeof(char) == 1, "Invalid char type on building platform.");
 	
-	/// Perform high page shrinking, which will attempt to lookup the high page break 
-	/// point and attempt to shrink.
-	void shrinkHighPage() noexcept {
-		bool hasPageShrinked;
-		do {
-			hasPageShrinked = false;
-			
-			// Scan every possible order number.
-			for(orderType order = 0; (order < buddyInfo::maxPageOrder) 
-					&& ((1 << order) <= hpbrk); ++ order) {
+	/// The start address of the first page managed by this allocator.
+	addressType pageBase;
+	
+	/// The recently freed pages of the low orders, which are still regarded in use
+	/// by the buddy system. The cached pages are linked by their free page nodes.
+	static_assert(buddyInfo::hotPageOrders <= buddyInfo::maxPageOrder,
+		"The orders of hot page cache exceed the page orders.");
+	static constexpr orderType hotPageSlots = buddyInfo::hotPageOrders > 0? buddyInfo::hotPageOrders : 1;
+	pageType hotPageList[hotPageSlots];
+	orderType hotPageCount[hotPageSlots];
+	
+	/// Perform one step of high page shrinking, which will lookup the free block right
+	/// under the high page break point and remove it. The number of pages shrunk is
+	/// returned, or 0 if the block under the break point is in use.
+	pfnType shrinkHighPageStep() noexcept {
+		// Scan every possible order number.
+		for(orderType order = 0; (order < buddyInfo::maxPageOrder) 
+				&& ((1 << order) <= hpbrk); ++ order) {
 
-				// Calculate page frame information.
-				pfnType pfn = hpbrk - (1 << order);
-				pfnType index, offset;
-				indexFrom(pfn, order, index, offset);
-				
-				// Check whether it is a page to shrink.
-				if(bitmapHas(index, offset)) {
-					// Remove the page from free list and unmask the bitmap.
-					pageType page = pageFrameFrom(pfn);
-					unlinkPage(page);
-					bitmapClear(index, offset);
-					
-					// Update the high page break value.
-					hpbrk = pfn;
-					hasPageShrinked = true;
-				}
+			// Calculate page frame information. The page of this order must be
+			// aligned, otherwise it belongs to a page of higher order.
+			pfnType pfn = hpbrk - (1 << order);
+			if((pfn & ((1 << order) - 1)) != 0) continue;
+			bitIndexType index, offset;
+			indexFrom(pfn, order, index, offset);
+			
+			// Check whether it is a page to shrink.
+			if(bitmapHas(index, offset)) {
+				// Remove the page from free list and unmask the bitmap.
+				pageType page = pageFrameFrom(pfn);
+				unlinkPage(page);
+				bitmapClear(index, offset);
 				
-				// Immediately start next loop if so.
-				if(hasPageShrinked) break;
+				// Update the high page break value.
+				hpbrk = pfn;
+				return 1 << order;
 			}
-		} while(hasPageShrinked);
+		}
+		return 0;
+	}
+	
+	/// Perform high page shrinking of at most (steps) steps, so that its cost is 
+	/// bounded. The number of pages shrunk is returned.
+	addressType shrinkHighPage(addressType steps) noexcept {
+		addressType shrunk = 0;
+		for(; steps > 0; -- steps) {
+			pfnType pages = shrinkHighPageStep();
+			if(pages == 0) break;
+			shrunk += pages;
+		}
+		return shrunk;
+	}
+	
+	/// Perform high page shrinking until the block under the high page break point
+	/// is in use. The number of pages shrunk is returned.
+	addressType shrinkHighPage() noexcept {
+		addressType shrunk = 0;
+		for(pfnType pages; (pages = shrinkHighPageStep()) > 0; ) shrunk += pages;
+		return shrunk;
 	}
 	
-	/// Return a high page back to the allocator.
+	/// Return a high page back to the allocator, which will be cached if its order
+	/// is low and there's still room in the cache.
 	void freeHighPage(pageType page, orderType order) noexcept {
 		if(page == (pageType)buddyInfo::nullPageAddress) return;
-		pfnType pfnCurrent = pageFrameFor(page);
+		if(order < buddyInfo::hotPageOrders && hotPageCount[order] < buddyInfo::hotPageDepth) {
+			page -> freePage.next = hotPageList[order];
+			hotPageList[order] = page;
+			++ hotPageCount[order];
+			return;
+		}
+		freeBuddyPage(page, order);
+	}
+	
+	/// Return the cached pages back to the buddy system, so that they could be merged
+	/// again. The number of pages drained is returned.
+	pfnType drainHotPages() noexcept {
+		pfnType drained = 0;
+		for(orderType order = 0; order < buddyInfo::hotPageOrders; ++ order) {
+			while(hotPageList[order] != (pageType)buddyInfo::nullPageAddress) {
+				pageType page = hotPageList[order];
+				hotPageList[order] = page -> freePage.next;
+				freeBuddyPage(page, order);
+				++ drained;
+			}
+			hotPageCount[order] = 0;
+		}
+		return drained;
+	}
+	
+	/// Allocate a high page from the allocator, from the cache first. If there's no
+	/// more page, the cache will be drained and the allocation will be retried.
+	pageType allocateHighPage(orderType order) noexcept {
+		if(order < buddyInfo::hotPageOrders && hotPageCount[order] > 0) {
+			pageType page = hotPageList[order];
+			hotPageList[order] = page -> freePage.next;
+			-- hotPageCount[order];
+			return page;
+		}
+		pageType page = allocateBuddyPage(order);
+		if(page == (pageType)buddyInfo::nullPageAddress && drainHotPages() > 0)
+			page = allocateBuddyPage(order);
+		return page;
+	}
+	
+	/// Return a high page back to the buddy system, merging with its buddies.
+	void freeBuddyPage(pageType page, orderType order) noexcept {
+		pfnType pfnCurrent = blockFrameOf(page, order);
 		
 		// Perform iterative merging of buddy page algorithm. Please notice that the 
 		// page is currently not inside a free list (However its buddy will be).
 		for(; order < buddyInfo::maxPageOrder - 1; ++ order) {
-			// Retrieve the buddy of current page frame number.
+			// Retrieve the buddy of current page frame number. The buddy above the 
+			// high break point is never free.
 			pfnType pfnBuddy = pfnCurrent ^ (1 << order);
-			pfnType buddyIndex, buddyOffset;
+			if(pfnBuddy >= hpbrk) break;
+			bitIndexType buddyIndex, buddyOffset;
 			indexFrom(pfnBuddy, order, buddyIndex, buddyOffset);
 			
 			// The buddy of current page is free too. Unlink the buddy from free list 
@@ -220,10 +359,12 @@ struct GmOsPageAllocatorBuddy {
 			else break;	// End up with no more buddy to merge.
 		}
 		
-		// The page is top page, so just perform shrinking.
+		// The page is top page, so just perform shrinking, which is bounded so that 
+		// the deallocation is done in constant time.
 		if(pfnCurrent + (1 << order) == hpbrk) {
 			hpbrk = pfnCurrent;
-			if(buddyInfo::deftHighBreakShrink) shrinkHighPage();
+			if(buddyInfo::deftHighBreakShrink) 
+				shrinkHighPage(buddyInfo::highBreakShrinkSteps);
 		}
 		
 		// Add specified page to corresponding free list.
@@ -231,7 +372,7 @@ struct GmOsPageAllocatorBuddy {
 			pageType currentPage = pageFrameFrom(pfnCurrent);
 			
 			// Retrieve the current page frame number.
-			pfnType currentIndex, currentOffset;
+			bitIndexType currentIndex, currentOffset;
 			indexFrom(pfnCurrent, order, currentIndex, currentOffset);
 			
 			// Add the page to corresponding free list.
@@ -240,8 +381,8 @@ struct GmOsPageAllocatorBuddy {
 		}
 	}
 	
-	/// Allocate a high page from the allocator.
-	pageType allocateHighPage(orderType order) noexcept {
+	/// Allocate a high page from the buddy system, splitting the larger pages.
+	pageType allocateBuddyPage(orderType order) noexcept {
 		if(order >= buddyInfo::maxPageOrder) 	// Cannot allocate.
 			return (pageType)buddyInfo::nullPageAddress;
 		
@@ -251,27 +392,27 @@ struct GmOsPageAllocatorBuddy {
 			
 			// Unset bitmap bit.
 			pfnType pfnResult = pageFrameFor(resultPage);
-			pfnType resultIndex, resultOffset;
+			bitIndexType resultIndex, resultOffset;
 			indexFrom(pfnResult, order, resultIndex, resultOffset);
 			
 			// Unlink current page.
 			bitmapClear(resultIndex, resultOffset);
 			unlinkPage(resultPage);
 			
-			return resultPage;
+			return blockAddressOf(pfnResult, order);
 		}
 		else {
 			// Increase up to the available order.
 			orderType availableOrder = order + 1;
 			for(; availableOrder < buddyInfo::maxPageOrder && 
-				freePageList[order] == (pageType)buddyInfo::nullPageAddress; 
+				freePageList[availableOrder] == (pageType)buddyInfo::nullPageAddress; 
 				++ availableOrder);
 			
 			if(availableOrder < buddyInfo::maxPageOrder) {
 				// Luckily we've found one, remove the page from free list first.
 				pageType victimPage = freePageList[availableOrder];
 				pfnType pfnVictim = pageFrameFor(victimPage);
-				pfnType victimIndex, victimOffset;
+				bitIndexType victimIndex, victimOffset;
 				indexFrom(pfnVictim, availableOrder, victimIndex, victimOffset);
 				bitmapClear(victimIndex, victimOffset);
 				unlinkPage(victimPage);
@@ -282,7 +423,7 @@ struct GmOsPageAllocatorBuddy {
 					
 					// Calculate the page to split.
 					pfnType pfnSplit = pfnVictim + (1 << availableOrder);
-					pfnType splitIndex, splitOffset;
+					bitIndexType splitIndex, splitOffset;
 					indexFrom(pfnSplit, availableOrder, splitIndex, splitOffset);
 					pageType splitPage = pageFrameFrom(pfnSplit);
 					
@@ -292,7 +433,7 @@ struct GmOsPageAllocatorBuddy {
 				} while(availableOrder != order);
 				
 				// The splitted page will be returned.
-				return victimPage;
+				return blockAddressOf(pfnVictim, order);
 			}
 			else {
 				// We have to increase the hpbrk, by find the last availabe page.
@@ -300,7 +441,7 @@ struct GmOsPageAllocatorBuddy {
 				pfnType newHpbrk = pfnNew + (1 << order);
 				
 				// Check whether more page can be allocated.
-				if(buddyInfo::totalPageFrame() < lpbrk + newHpbrk) 
+				if(totalPageFrame() < lpbrk + newHpbrk) 
 					return (pageType)buddyInfo::nullPageAddress;
 				
 				// Add some free page between the old hpbrk and the new page frame.
@@ -311,7 +452,7 @@ struct GmOsPageAllocatorBuddy {
 					pfnSplit = pfnSplit - pfnDecrement;
 					
 					// Calculate the page to split.
-					pfnType splitIndex, splitOffset;
+					bitIndexType splitIndex, splitOffset;
 					indexFrom(pfnSplit, orderSplit - 1, splitIndex, splitOffset);
 					pageType splitPage = pageFrameFrom(pfnSplit);
 					
@@ -322,38 +463,288 @@ struct GmOsPageAllocatorBuddy {
 				
 				// Update the high break and return.
 				hpbrk = newHpbrk;
-				return pageFrameFrom(pfnNew);
+				pageUsage.observeUsage(lpbrk + hpbrk);
+				return blockAddressOf(pfnNew, order);
 			}
 		}
 	}
 	
+	/// Allocate at most (count) blocks of the order from the buddy system. Every block
+	/// found in the free lists is taken once, and its pieces are handed out, with the 
+	/// remained pieces returned as aligned blocks.
+	addressType allocateBuddyPages(orderType order, addressType count, pageType* pages) noexcept {
+		addressType allocated = 0;
+		while(allocated < count) {
+			// Find the lowest order of available block.
+			orderType availableOrder = order;
+			for(; availableOrder < buddyInfo::maxPageOrder && 
+				freePageList[availableOrder] == (pageType)buddyInfo::nullPageAddress; 
+				++ availableOrder);
+			
+			// Increase the hpbrk by the single page path if there's no block.
+			if(availableOrder >= buddyInfo::maxPageOrder) {
+				pageType page = allocateBuddyPage(order);
+				if(page == (pageType)buddyInfo::nullPageAddress) break;
+				pages[allocated ++] = page;
+				continue;
+			}
+			
+			// Remove the block from free list.
+			pageType victimPage = freePageList[availableOrder];
+			pfnType pfnVictim = pageFrameFor(victimPage);
+			bitIndexType victimIndex, victimOffset;
+			indexFrom(pfnVictim, availableOrder, victimIndex, victimOffset);
+			bitmapClear(victimIndex, victimOffset);
+			unlinkPage(victimPage);
+			
+			// Hand out the pieces of the block.
+			addressType pieces = 1 << (availableOrder - order);
+			addressType taken = (count - allocated < pieces)? count - allocated : pieces;
+			for(addressType piece = 0; piece < taken; ++ piece)
+				pages[allocated ++] = blockAddressOf(pfnVictim + (piece << order), order);
+			
+			// Return the remained pieces, where the largest aligned block at a piece is 
+			// given by its lowest set bit. Their buddies are in use, so no merging.
+			for(addressType piece = taken; piece < pieces; ) {
+				addressType span = piece & (~piece + 1);
+				orderType spanOrder = order;
+				for(addressType spanRemain = span; spanRemain > 1; spanRemain >>= 1) ++ spanOrder;
+				
+				pfnType pfnSpan = pfnVictim + (piece << order);
+				bitIndexType spanIndex, spanOffset;
+				indexFrom(pfnSpan, spanOrder, spanIndex, spanOffset);
+				bitmapSet(spanIndex, spanOffset);
+				linkPage(&freePageList[spanOrder], pageFrameFrom(pfnSpan));
+				piece += span;
+			}
+		}
+		return allocated;
+	}
+	
+	/// Allocate at most (count) high pages of the order into the array, from the cache 
+	/// first. The number of pages allocated is returned, which is less than (count) 
+	/// only if the pages are exhausted.
+	addressType allocateHighPages(orderType order, addressType count, pageType* pages) noexcept {
+		if(order >= buddyInfo::maxPageOrder) return 0;
+		addressType allocated = 0;
+		
+		// Pop the cached pages.
+		if(order < buddyInfo::hotPageOrders) {
+			for(; allocated < count && hotPageCount[order] > 0; ++ allocated) {
+				pages[allocated] = hotPageList[order];
+				hotPageList[order] = pages[allocated] -> freePage.next;
+				-- hotPageCount[order];
+			}
+		}
+		
+		// Allocate the remained pages, draining the cache if exhausted.
+		allocated += allocateBuddyPages(order, count - allocated, pages + allocated);
+		if(allocated < count && drainHotPages() > 0)
+			allocated += allocateBuddyPages(order, count - allocated, pages + allocated);
+		return allocated;
+	}
+	
+	/// Return the high pages of the order in the array. The consecutive pages forming
+	/// an aligned block, like the ones allocated together, are returned as the block,
+	/// so only one bitmap bit is set for them. Null pages are skipped.
+	void freeHighPages(orderType order, addressType count, pageType* pages) noexcept {
+		addressType index = 0;
+		while(index < count) {
+			if(pages[index] == (pageType)buddyInfo::nullPageAddress) { ++ index; continue; }
+			
+			// Double the run while the pages are consecutive and the run is aligned.
+			pfnType pfnFirst = blockFrameOf(pages[index], order);
+			orderType runOrder = order;
+			addressType runLength = 1;
+			while(runOrder + 1 < buddyInfo::maxPageOrder) {
+				addressType doubled = runLength << 1;
+				if((pfnFirst & ((1 << (runOrder + 1)) - 1)) != 0) break;
+				if(index + doubled > count) break;
+				
+				addressType piece = runLength;
+				for(; piece < doubled; ++ piece) {
+					if(pages[index + piece] == (pageType)buddyInfo::nullPageAddress) break;
+					if(blockFrameOf(pages[index + piece], order) != 
+						pfnFirst + (piece << order)) break;
+				}
+				if(piece < doubled) break;
+				runLength = doubled; ++ runOrder;
+			}
+			
+			// Return the run as a whole block.
+			if(runOrder == order) freeHighPage(pages[index], order);
+			else freeBuddyPage(blockAddressOf(pfnFirst, runOrder), runOrder);
+			index += runLength;
+		}
+	}
+	
 	/// Retrieve the current low break point top page.
 	pageType lowPageBreak() const noexcept {
 		if(lpbrk == 0) return (pageType)buddyInfo::nullPageAddress;
 		else return reinterpret_cast<pageType>(((lpbrk - 1) 
-			<< buddyInfo::pageSizeShift) + buddyInfo::firstPageAddress());
+			<< buddyInfo::pageSizeShift) + firstPageAddress());
 	}
 	
 	/// Increase the low page break point from the allocator. If the page increment 
 	/// has succeed, the true will be returned and low break point will be changed, 
-	/// otherwise false will be returned and nothing is changed.
+	/// otherwise false will be returned and nothing is changed. The cached pages
+	/// will be drained and the deferred shrinking will be finished when failed, 
+	/// which might lower the high break point.
 	bool allocateLowPage(pfnType pageCount) noexcept {
 		pfnType newLpbrk = lpbrk + pageCount;
 		
-		if(buddyInfo::totalPageFrame() < newLpbrk + hpbrk) return false;
-		lpbrk = newLpbrk; return true;
+		if(totalPageFrame() < newLpbrk + hpbrk) {
+			pfnType drained = drainHotPages();
+			if(shrinkHighPage() == 0 && drained == 0) return false;
+			if(totalPageFrame() < newLpbrk + hpbrk) return false;
+		}
+		lpbrk = newLpbrk;
+		pageUsage.observeUsage(lpbrk + hpbrk);
+		return true;
 	};
 	
 	/// Decrease the low page break point from the allocator.
 	bool freeLowPage(pfnType numFree) noexcept {
 		if(lpbrk >= numFree) lpbrk = lpbrk - numFree;
 		else lpbrk = 0;
+		return true;
+	}
+	
+	/// Count the free blocks of the order in the buddy system. The cached pages 
+	/// are still regarded in use and not counted.
+	pfnType freeBlockCount(orderType order) const noexcept {
+		pfnType count = 0;
+		if(order >= buddyInfo::maxPageOrder) return count;
+		for(pageType page = freePageList[order]; page != (pageType)
+			buddyInfo::nullPageAddress; page = page -> freePage.next) ++ count;
+		return count;
 	}
 	
-	/// Initialize the buddy info structure.
-	GmOsPageAllocatorBuddy() noexcept: lpbrk(0), hpbrk(0) {
+	/// Retrieve the number of cached pages of the order.
+	inline orderType cachedPageCount(orderType order) const noexcept {
+		return order < buddyInfo::hotPageOrders? hotPageCount[order] : 0;
+	}
+	
+	/// Retrieve the peak of page frames below both break points, or 0 if the 
+	/// statistics are not collected.
+	inline pfnType peakPageFrame() const noexcept { return pageUsage.peakUsage(); }
+	
+	/// Initialize the buddy info structure, managing the pages specified by the 
+	/// buddy info.
+	GmOsPageAllocatorBuddy() noexcept: lpbrk(0), hpbrk(0), 
+		pageCount(buddyInfo::totalPageFrame()), 
+		pageBase(buddyInfo::firstPageAddress()) {
 		buddyInfo::memzptr(freePageList, 
 			(pageType)buddyInfo::nullPageAddress, buddyInfo::maxPageOrder);
-		buddyInfo::memzero(bitmap, buddyInfo::bitmapTotalSize);
+		buddyInfo::memzero(bitmap, bitmapTotalSize);
+		buddyInfo::memzptr(hotPageList, 
+			(pageType)buddyInfo::nullPageAddress, hotPageSlots);
+		buddyInfo::memzero(reinterpret_cast<char*>(hotPageCount), sizeof(hotPageCount));
 	}
+	
+	/// Initialize the buddy info structure, managing a span of pages starting from
+	/// the specified address. (The span is usually allocated from another allocator).
+	GmOsPageAllocatorBuddy(addressType spanBase, pfnType spanCount) noexcept: 
+		lpbrk(0), hpbrk(0), pageCount(spanCount), pageBase(spanBase) {
+		buddyInfo::memzptr(freePageList, 
+			(pageType)buddyInfo::nullPageAddress, buddyInfo::maxPageOrder);
+		buddyInfo::memzero(bitmap, bitmapTotalSize);
+		buddyInfo::memzptr(hotPageList, 
+			(pageType)buddyInfo::nullPageAddress, hotPageSlots);
+		buddyInfo::memzero(reinterpret_cast<char*>(hotPageCount), sizeof(hotPageCount));
+	}
+};
+
+/**
+ * The pages reserved from a page allocator, for the phases where the allocation
+ * must neither fail nor stall. The pages are pulled out of the page allocator in
+ * advance, and then allocated and deallocated in O(1) by a singly linked list 
+ * through their free page nodes, until the reservation is released explicitly.
+ */
+template<typename pageAllocatorType>
+struct GmOsPageReserve {
+	/// Forward template types ahead.
+	typedef typename pageAllocatorType::orderType orderType;
+	typedef typename pageAllocatorType::addressType addressType;
+	typedef typename pageAllocatorType::pageType pageType;
+	
+	/// How many pages are pulled or returned at once in batch.
+	static constexpr addressType batchSize = 8;
+	
+	/// The page allocator which the pages are reserved from.
+	pageAllocatorType& pageAllocator;
+	
+	/// The first reserved page that is not in use.
+	pageType head;
+	
+	/// The number of reserved pages, and the ones not in use.
+	addressType total, available;
+	
+	/// The order of the reserved pages.
+	orderType order;
+	
+	/// Constructor for the reservation, which reserves nothing.
+	GmOsPageReserve(pageAllocatorType& pageAllocator, orderType order) noexcept:
+		pageAllocator(pageAllocator), head(nullptr), total(0), available(0), order(order) {}
+	
+	/// Push a page onto the reserved list.
+	inline void push(pageType page) noexcept {
+		page -> freePage.next = head;
+		head = page;
+		++ available;
+	}
+	
+	/// Reserve (count) more pages. The reservation is all or nothing, so the pages 
+	/// pulled will be returned if not all of them could be reserved.
+	bool reserve(addressType count) noexcept {
+		pageType pages[batchSize];
+		addressType reserved = 0;
+		while(reserved < count) {
+			addressType request = (count - reserved < batchSize)? count - reserved : batchSize;
+			addressType pulled = pageAllocator.allocateHighPages(order, request, pages);
+			
+			// Link in the reversed order, so that they are popped in allocated order.
+			for(addressType index = pulled; index > 0; -- index) push(pages[index - 1]);
+			reserved += pulled; total += pulled;
+			if(pulled < request) break;
+		}
+		if(reserved < count) {
+			release(reserved);
+			return false;
+		}
+		return true;
+	}
+	
+	/// Allocate a reserved page, or null page if the reservation is exhausted.
+	inline pageType allocate() noexcept {
+		if(head == nullptr) return head;
+		pageType page = head;
+		head = page -> freePage.next;
+		-- available;
+		return page;
+	}
+	
+	/// Deallocate a page back to the reservation.
+	inline void deallocate(pageType page) noexcept {
+		if(page == nullptr) return;
+		push(page);
+	}
+	
+	/// Return at most (count) unused reserved pages back to the page allocator. The 
+	/// number of pages returned is returned.
+	addressType release(addressType count) noexcept {
+		pageType pages[batchSize];
+		addressType released = 0;
+		while(released < count && head != nullptr) {
+			addressType batch = 0;
+			for(; batch < batchSize && released + batch < count && head != nullptr; ++ batch)
+				pages[batch] = allocate();
+			pageAllocator.freeHighPages(order, batch, pages);
+			released += batch; total -= batch;
+		}
+		return released;
+	}
+	
+	/// Return all unused reserved pages back to the page allocator.
+	inline addressType release() noexcept { return release(available); }
 };
\ No newline at end of file
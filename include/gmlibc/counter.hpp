@@ -0,0 +1,42 @@
+#pragma once
+/**
+ * @file gmlibc/counter.hpp
+ * @brief Usage Counter of Allocators
+ * @author Haoran Luo
+ *
+ * The counter records the current and peak usage of an allocator. When it is 
+ * disabled, the counter is empty and its updates do nothing, so that the
+ * allocators could privately inherit it (the empty base optimization), and
+ * the statistics are compiled to nothing in release builds.
+ */
+
+template<typename sizeType, bool enabled>
+struct GmOsUsageCounter {
+	/// The current and peak usage.
+	sizeType current, peak;
+	
+	GmOsUsageCounter() noexcept: current(0), peak(0) {}
+	
+	/// Retrieve the current and peak usage.
+	inline sizeType currentUsage() const noexcept { return current; }
+	inline sizeType peakUsage() const noexcept { return peak; }
+	
+	/// Update the usage, and the peak if exceeded.
+	inline void observeUsage(sizeType usage) noexcept {
+		current = usage;
+		if(current > peak) peak = current;
+	}
+	
+	inline void increaseUsage(sizeType amount) noexcept { observeUsage(current + amount); }
+	inline void decreaseUsage(sizeType amount) noexcept { current -= amount; }
+};
+
+/// The disabled counter, which records nothing.
+template<typename sizeType>
+struct GmOsUsageCounter<sizeType, false> {
+	inline sizeType currentUsage() const noexcept { return 0; }
+	inline sizeType peakUsage() const noexcept { return 0; }
+	inline void observeUsage(sizeType) noexcept {}
+	inline void increaseUsage(sizeType) noexcept {}
+	inline void decreaseUsage(sizeType) noexcept {}
+};
@@ -7,14 +7,12 @@
  * This allocator is based on the work of Doug Lea's malloc allocator, whose 
  * variants ptmalloc2 is used in pthread's malloc and glibc's malloc.
  *
- * The allocator divides a memory allocate request into 4 parts:
- * - FastBin: For memory request who are really small, the last memory returned 
- * will be popped from the bin. (LIFO) All Fast bin chunks are equally sized.
- * - SmallBin: For memory request that are relative small, find the first page 
- * (returned) that fits in with the allocator best and potentially split that
- * page into two parts. (Pages are sorted but not ordered).
- * - LargeBin: For memory request that are relative big, find the best fit chunk, 
- * and potentially split that page into two parts.
+ * The allocator divides a memory allocate request into 3 parts:
+ * - SmallBin: For memory request that are relative small, the bins are spaced by
+ * 8 bytes so that any chunk in the bin fits in with the request, and the last
+ * chunk returned will be popped from the bin. (LIFO)
+ * - TreeBin: For memory request that are relative big, find the best fit chunk in
+ * the size tree, and potentially split that page into two parts.
  * - PageChunk: For memory request that are of page size, directly allocate the 
  * page with the page allocator.
  *
@@ -28,22 +26,45 @@
  * +----------------------+
  * | NextChunkPointer     | (Circular link list pointing to next free page).
  * +----------------------+
- * | PreviousSizePointer  | 
+ * | ChildPointers[2]     | (Only used in tree bin, to point to the subtrees).
  * +----------------------+
- * | NextSizePointer      | (Only used in large bin and head node, to point to the 
- * +----------------------+ chunk strip of next size).
+ * | ParentPointer        | (Only used in tree bin, null for the peers of a size).
+ * +----------------------+
+ * | TreeIndex            | (Only used for large chunk, the tree bin it lies in).
+ * +----------------------+
+ *
+ * The small bin of a chunk is indexed by (size >> 3), while the request looks up the
+ * bin indexed by rounding its size up, as the chunk sizes are aligned to 4 bytes and
+ * a bin holds 2 sizes. A bitmap of non-empty small bins leads to the next larger 
+ * bin on a miss, so that both the hit and the miss take constant steps.
+ *
+ * The tree bins hold the chunks of (1 << smallbinMaxOrder) bytes or more, one bin
+ * for each power of 2, while the last bin holds all chunks no less than a page. 
+ * Each bin is a bitwise trie keyed by the bits of chunk size below the leading
+ * bit, like the treebins of Doug Lea's malloc. Only one chunk of a size lies in 
+ * the trie, and its peers of the same size are linked in a ring through it. So
+ * both the insertion and the best fit lookup walk at most one path of the trie.
  *
  * The page chunk threshold will be (pageSize - 2 * (sizeType)), this ensure at most
- * one low page will grow every malloc call.
+ * one page is lacking for every malloc call. The top chunk grows by the pages lacking
+ * and dlInfo::topPadPages more, and is trimmed only if more than the free pages of 
+ * dlInfo::trimThresholdPages lie on it, keeping the pad pages. So the allocations 
+ * near the top will not grow and shrink the low break point back and forth, like
+ * the M_TOP_PAD and M_TRIM_THRESHOLD of Doug Lea's malloc.
+ *
+ * The bytes in use and their peak are counted if dlInfo::collectStatistics is set,
+ * and the counter is privately inherited so that it costs nothing otherwise.
  */
+#include "gmlibc/counter.hpp"
 
 template<typename dlInfo, typename pageAllocatorType>
-struct GmOsFineAllocatorDlMalloc {
+struct GmOsFineAllocatorDlMalloc : private GmOsUsageCounter<
+	typename dlInfo::allocateSizeType, dlInfo::collectStatistics> {
 	// Forward the information definition.
 	typedef typename dlInfo::allocateSizeType allocateSizeType;
 	typedef typename dlInfo::chunkSizeType chunkSizeType;
 	typedef typename dlInfo::addressType addressType;
-	typedef typename dlInfo::pfnType pfnType;
+	typedef typename pageAllocatorType::pfnType pfnType;
 	typedef typename pageAllocatorType::pageType pageType;
 	typedef typename dlInfo::orderType orderType;
 	
@@ -76,38 +97,20 @@ struct GmOsFineAllocatorDlMalloc {
 		}
 	};
 	
-	/// When the chunk is large, maintaining the node.
-	struct GmOsChunkNodeLarge : public GmOsChunkNodeSmall {
-		/// Only the first node of a size will possess this field, other node will just 
-		/// have either node set to null address.
-		GmOsChunkNodeLarge *previousSize, *nextSize;
-		
-		/// Unlink the node from its context, assuming the node is in large bin.
-		inline void unlinkChunk() noexcept {
-			// Perform peer node checking.
-			if(	nextSize == GmOsChunkNodeSmall::next || 
-				GmOsChunkNodeSmall::next == (GmOsChunkNodeSmall*)dlInfo::nullChunkAddress) {
-				// There's no peer node after this node.
-				if(previousSize != (GmOsChunkNodeLarge*)dlInfo::nullChunkAddress) 
-					previousSize -> nextSize = nextSize;
-				
-				if(nextSize != (GmOsChunkNodeLarge*)dlInfo::nullChunkAddress) 
-					nextSize -> previousSize = previousSize;				
-			}
-			else {
-				// Elevate the peer node of current node.
-				GmOsChunkNodeLarge* nextNode = ((GmOsChunkNodeLarge*)GmOsChunkNodeSmall::next);
-				nextNode -> previousSize = previousSize;
-				nextNode -> nextSize = nextSize;
-				if(previousSize != (GmOsChunkNodeLarge*)dlInfo::nullChunkAddress) previousSize -> nextSize = nextNode;
-				if(nextSize != (GmOsChunkNodeLarge*)dlInfo::nullChunkAddress) nextSize -> previousSize = nextNode;
-			}
-			
-			// Unlink the size node.
-			previousSize = nextSize = (GmOsChunkNodeLarge*)dlInfo::nullChunkAddress;
-			
-			// Perform normal unlinking just like the small nodes.
-			GmOsChunkNodeSmall::unlinkChunk();
+	/// When the chunk is large, maintaining the node of size tree. The (previous, next)
+	/// links the ring of the chunks of the same size.
+	struct GmOsChunkNodeTree : public GmOsChunkNodeSmall {
+		/// The subtrees of the smaller and larger keys, and the parent of the node. The 
+		/// parent of the root is its bin, and the peers of the node have null parent.
+		GmOsChunkNodeTree *child[2], *parent;
+		
+		/// The tree bin that the chunk lies in, or treeBinNone if the chunk is not in a
+		/// tree bin (e.g. it is in the unsorted bin).
+		orderType index;
+		
+		/// Retrieve the leftmost child, which leads to the smallest chunk of subtree.
+		inline GmOsChunkNodeTree* leftmostChild() const noexcept {
+			return child[0] != (GmOsChunkNodeTree*)dlInfo::nullChunkAddress? child[0] : child[1];
 		}
 	};
 	
@@ -121,12 +124,12 @@ struct GmOsFineAllocatorDlMalloc {
 		
 		/// The chunk node union, depending on which bin is the node inside.
 		union {
-			/// When the node is inside fast, small or unsorted bin, this node will 
+			/// When the node is inside small or unsorted bin, this node will 
 			/// be made available.
 			GmOsChunkNodeSmall small;
 			
-			/// When the node is inside large bin, this node will be made available.
-			GmOsChunkNodeLarge large;
+			/// When the node is inside tree bin, this node will be made available.
+			GmOsChunkNodeTree tree;
 			
 			/// Returned by the allocator as the memory.
 			char memory[1];
@@ -187,9 +190,7 @@ struct GmOsFineAllocatorDlMalloc {
 		
 		/// See whether a chunk suits the size requirement of large chunk.
 		inline bool isLargeChunkSize() const noexcept {
-			chunkSizeType sizeValue = size();
-			return (sizeValue >= (1 << dlInfo::smallbinMaxOrder)) 
-				&& (sizeValue <  (1 << dlInfo::pageSizeShift));
+			return size() >= (1 << dlInfo::smallbinMaxOrder);
 		}
 	};
 	typedef GmOsFineChunkDlMalloc* chunkType;
@@ -208,36 +209,52 @@ struct GmOsFineAllocatorDlMalloc {
 	/// Pointing to the top chunk, which ought to be initialized before any allocation.
 	chunkType topChunk;
 	
-	/// The fastbin, small bin, large bin and unsorted bin.
-	/// Please notice that 0, 1, 2 of the fast bin is not used. Depending on the system
-	/// word length, the 3 might also be not used.
-	GmOsChunkNodeSmall fast[dlInfo::fastbinMaxOrder];
-	GmOsChunkNodeSmall small[dlInfo::smallbinMaxOrder - dlInfo::fastbinMaxOrder];
-	GmOsChunkNodeLarge large[dlInfo::pageSizeShift - dlInfo::smallbinMaxOrder];
+	/// The tree bins, one for each power of 2 from the small bin maximum order, and 
+	/// the last one for the chunks no less than a page.
+	static constexpr orderType treeBinCount = dlInfo::pageSizeShift - dlInfo::smallbinMaxOrder + 1;
+	static constexpr orderType treeBinNone = treeBinCount;
+	static_assert(treeBinCount <= sizeof(unsigned int) * 8, "Too many tree bins for the tree map.");
+	
+	/// The top chunk kept under the trim threshold should be sized by chunk size type.
+	static_assert((((allocateSizeType)(dlInfo::trimThresholdPages + dlInfo::topPadPages + 2) 
+		<< dlInfo::pageSizeShift) - 1) <= (chunkSizeType)~(chunkSizeType)0,
+		"The top chunk under the trim threshold overflows the chunk size.");
+	
+	/// The bits of allocate size, where the trie keys are shifted to the top bit.
+	static constexpr orderType sizeBits = sizeof(allocateSizeType) * 8;
+	
+	/// The small bins spaced by (1 << smallBinShift) bytes, below the tree bins. The bin 
+	/// 0 is never used, as the chunk is no smaller than the node.
+	static constexpr orderType smallBinShift = 3;
+	static constexpr unsigned int smallBinCount = 1u << (dlInfo::smallbinMaxOrder - smallBinShift);
+	static constexpr unsigned int smallMapBits = sizeof(unsigned int) * 8;
+	static constexpr unsigned int smallMapWords = (smallBinCount + smallMapBits - 1) / smallMapBits;
+	
+	/// The small bin, tree bin and unsorted bin. Only the head of the small bin is 
+	/// stored, see smallBinNode() for how it is linked.
+	GmOsChunkNodeSmall* small[smallBinCount];
+	GmOsChunkNodeTree* tree[treeBinCount];
 	GmOsChunkNodeSmall unsorted;
 	
+	/// The bitmaps of non-empty small bins and tree bins. The bit of small bin might 
+	/// be left set after its last chunk is coalsced, and will be cleared on search.
+	unsigned int smallMap[smallMapWords];
+	unsigned int treeMap;
+	
 	/// Constructor for the malloc class.
 	GmOsFineAllocatorDlMalloc(pageAllocatorType& pageAllocator) noexcept: 
 		pageAllocator(pageAllocator), 
-		topChunk((chunkType)dlInfo::nullChunkAddress) {
+		topChunk((chunkType)dlInfo::nullChunkAddress), treeMap(0) {
 		
 		// Prepare temporary null nodes for initialization.
 		GmOsChunkNodeSmall nullSmallNode;
 		nullSmallNode.previous = (GmOsChunkNodeSmall*)dlInfo::nullChunkAddress;
 		nullSmallNode.next = (GmOsChunkNodeSmall*)dlInfo::nullChunkAddress;
 		
-		GmOsChunkNodeLarge nullLargeNode;
-		nullLargeNode.GmOsChunkNodeSmall::previous = (GmOsChunkNodeSmall*)dlInfo::nullChunkAddress;
-		nullLargeNode.GmOsChunkNodeSmall::next = (GmOsChunkNodeSmall*)dlInfo::nullChunkAddress;
-		nullLargeNode.previousSize = (GmOsChunkNodeLarge*)dlInfo::nullChunkAddress;
-		nullLargeNode.nextSize = (GmOsChunkNodeLarge*)dlInfo::nullChunkAddress;
-		
-		// Make the fast bin a stack.
-		dlInfo::memzptr(fast, nullSmallNode, dlInfo::fastbinMaxOrder);
-		
-		// Make both of them a circular link list (queue).
-		dlInfo::memzptr(small, nullSmallNode, dlInfo::smallbinMaxOrder - dlInfo::fastbinMaxOrder);
-		dlInfo::memzptr(large, nullLargeNode, dlInfo::pageSizeShift - dlInfo::smallbinMaxOrder);
+		// Make the small bins and the tree bins empty.
+		dlInfo::memzptr(small, (GmOsChunkNodeSmall*)dlInfo::nullChunkAddress, smallBinCount);
+		dlInfo::memzptr(tree, (GmOsChunkNodeTree*)dlInfo::nullChunkAddress, treeBinCount);
+		dlInfo::memzero((char*)smallMap, sizeof(smallMap));
 				
 		// Make the unsorted bin a stack.
 		dlInfo::memzptr(&unsorted, nullSmallNode, 1);
@@ -258,35 +275,255 @@ struct GmOsFineAllocatorDlMalloc {
 		return true;
 	}
 	
-	/// Increase the top chunk by a page on request. If the increment can process,
-	/// true will be returned, otherwise false will be returned and the allocator 
-	/// should return null chunk (indicating allocation failure) under such situation.
-	bool increaseTopChunk() noexcept {
+	/// Increase the top chunk to hold the physical size on request, by the pages lacking 
+	/// and the pad pages if possible. If the increment can process, true will be returned,
+	/// otherwise false will be returned and the allocator should return null chunk 
+	/// (indicating allocation failure) under such situation.
+	bool increaseTopChunk(allocateSizeType physicalSize) noexcept {
 		if(!topChunkInitialize()) return false;
-		
-		/// Update the chunk size by one page.
-		if(!pageAllocator.allocateLowPage(1)) return false;
-		topChunk -> updateSize(topChunk -> size() + (1 << dlInfo::pageSizeShift));
+		if(physicalSize <= topChunk -> size()) return true;
+		
+		/// Grow with the pad pages, or just the pages lacking when there's no room.
+		pfnType pageCount = (physicalSize - topChunk -> size() 
+			+ ((1 << dlInfo::pageSizeShift) - 1)) >> dlInfo::pageSizeShift;
+		if(dlInfo::topPadPages > 0 && pageAllocator.allocateLowPage(
+			pageCount + dlInfo::topPadPages)) pageCount += dlInfo::topPadPages;
+		else if(!pageAllocator.allocateLowPage(pageCount)) return false;
+		
+		/// Update the chunk size by the pages.
+		topChunk -> updateSize(topChunk -> size() + 
+			((allocateSizeType)pageCount << dlInfo::pageSizeShift));
 		return true;
 	}
 	
-	/// Shrink the top chunk after deallocation besides top chunk. Under which case the 
-	/// top chunk will go across one or more page size.
-	void shrinkTopChunk() noexcept {
-		if(!topChunkInitialize()) return;	// No need to shrink this case.
-		
-		/// Get the last un-shrinkable word's address and page frame.
+	/// Retrieve the pages of top chunk that could be returned to the page allocator,
+	/// which are the whole pages after the page of its last un-shrinkable word.
+	pfnType topChunkFreePages() const noexcept {
+		if(topChunk == (chunkType)dlInfo::nullChunkAddress) return 0;
 		addressType chunkSizeAddress = reinterpret_cast<addressType>(&(topChunk -> chunkSize));
 		pfnType pfnChunkSize = chunkSizeAddress >> dlInfo::pageSizeShift;
 		pfnType pfnLowBreak = reinterpret_cast<addressType>(
 			pageAllocator.lowPageBreak()) >> dlInfo::pageSizeShift;
+		return pfnLowBreak - pfnChunkSize;
+	}
+	
+	/// Shrink the top chunk, returning its free pages except for the pad pages to the 
+	/// page allocator. The number of pages returned will be returned.
+	pfnType shrinkTopChunk(pfnType padPages) noexcept {
+		pfnType freePages = topChunkFreePages();
+		if(freePages <= padPages) return 0;
+		freePages -= padPages;
 		
 		// Return the page to the page allocator and shrink the size.
-		pageAllocator.freeLowPage(pfnLowBreak - pfnChunkSize);
+		pageAllocator.freeLowPage(freePages);
 		topChunk -> updateSize(topChunk -> size() - 
-			((pfnLowBreak - pfnChunkSize) << dlInfo::pageSizeShift));
+			((allocateSizeType)freePages << dlInfo::pageSizeShift));
+		return freePages;
 	}
 		
+	/// Retrieve the tree bin that a size lies in. The sizes below the first tree bin
+	/// are regarded in the first one.
+	static inline orderType treeIndexOf(allocateSizeType size) noexcept {
+		orderType index = 0;
+		for(size >>= dlInfo::smallbinMaxOrder + 1; size != 0 
+			&& index < treeBinCount - 1; size >>= 1) ++ index;
+		return index;
+	}
+	
+	/// Retrieve the shift moving the first key bit of the tree bin to the top bit. 
+	/// The leading bit is the same for the chunks in a tree bin except the last one,
+	/// whose chunks are keyed by the whole size.
+	static inline orderType treeShiftOf(orderType index) noexcept {
+		return (index == treeBinCount - 1)? 0 : sizeBits - (dlInfo::smallbinMaxOrder + index);
+	}
+	
+	/// Retrieve the pseudo node of the tree bin, which is the parent of its root.
+	inline GmOsChunkNodeTree* treeBinNode(orderType index) noexcept {
+		return reinterpret_cast<GmOsChunkNodeTree*>(&tree[index]);
+	}
+	
+	/// Retrieve the pseudo node of the small bin, whose next pointer is the head of the 
+	/// bin. The previous pointer of the pseudo node overlaps the bin before and is never
+	/// accessed, as the node is always the first of the list.
+	inline GmOsChunkNodeSmall* smallBinNode(unsigned int index) noexcept {
+		return reinterpret_cast<GmOsChunkNodeSmall*>(reinterpret_cast<addressType>(
+			&small[index]) - sizeof(GmOsChunkNodeSmall*));
+	}
+	
+	/// Find the chunk in the first non-empty small bin that is no smaller than the bin
+	/// of the size, or null if there's no such chunk. The chunk found is not unlinked.
+	chunkType searchSmallChunk(allocateSizeType size) noexcept {
+		unsigned int index = (size + (1 << smallBinShift) - 1) >> smallBinShift;
+		while(index < smallBinCount) {
+			// Find the next bin marked in the bitmap, skipping the empty words.
+			unsigned int word = index / smallMapBits;
+			unsigned int bits = smallMap[word] >> (index % smallMapBits);
+			if(bits == 0) { index = (word + 1) * smallMapBits; continue; }
+			for(; (bits & 1) == 0; bits >>= 1) ++ index;
+			
+			// The chunk is available, or the bit is left set and should be cleared.
+			if(small[index] != (GmOsChunkNodeSmall*)dlInfo::nullChunkAddress) 
+				return chunkOf(small[index]);
+			smallMap[word] &= ~(1u << (index % smallMapBits));
+			++ index;
+		}
+		return (chunkType)dlInfo::nullChunkAddress;
+	}
+	
+	/// Insert the large chunk into its tree bin. The chunk will be linked into the trie
+	/// if it is the first chunk of its size, otherwise it will be linked as a peer.
+	void insertTreeChunk(chunkType chunk) noexcept {
+		GmOsChunkNodeTree* node = &(chunk -> payload.tree);
+		allocateSizeType size = chunk -> size();
+		orderType index = treeIndexOf(size);
+		node -> index = index;
+		node -> child[0] = node -> child[1] = (GmOsChunkNodeTree*)dlInfo::nullChunkAddress;
+		
+		// The chunk becomes the root of the empty tree bin.
+		if(tree[index] == (GmOsChunkNodeTree*)dlInfo::nullChunkAddress) {
+			treeMap |= (1u << index);
+			tree[index] = node;
+			node -> parent = treeBinNode(index);
+			node -> next = node -> previous = node;
+			return;
+		}
+		
+		// Walk down the trie by the key bits, until a chunk of the same size or an 
+		// empty child is found.
+		GmOsChunkNodeTree* current = tree[index];
+		allocateSizeType key = size << treeShiftOf(index);
+		while(chunkOf(current) -> size() != size) {
+			GmOsChunkNodeTree** child = &(current -> child[key >> (sizeBits - 1)]);
+			key <<= 1;
+			if(*child == (GmOsChunkNodeTree*)dlInfo::nullChunkAddress) {
+				*child = node;
+				node -> parent = current;
+				node -> next = node -> previous = node;
+				return;
+			}
+			current = *child;
+		}
+		
+		// Link the chunk into the ring of its peers.
+		node -> parent = (GmOsChunkNodeTree*)dlInfo::nullChunkAddress;
+		node -> previous = current;
+		node -> next = current -> next;
+		current -> next -> previous = node;
+		current -> next = node;
+	}
+	
+	/// Unlink the large chunk from its tree bin. If the chunk is in the trie, it will be
+	/// replaced by one of its peers, or a leaf of its subtrees.
+	void unlinkTreeChunk(chunkType chunk) noexcept {
+		GmOsChunkNodeTree* node = &(chunk -> payload.tree);
+		GmOsChunkNodeTree* parent = node -> parent;
+		GmOsChunkNodeTree* replace = (GmOsChunkNodeTree*)dlInfo::nullChunkAddress;
+		
+		// Unlink from the ring, and the peer will replace the chunk.
+		if(node -> next != node) {
+			replace = static_cast<GmOsChunkNodeTree*>(node -> previous);
+			node -> next -> previous = node -> previous;
+			node -> previous -> next = node -> next;
+		}
+		
+		// Detach the rightmost leaf of the subtrees, which will replace the chunk.
+		else {
+			GmOsChunkNodeTree** replaceLink = &(node -> child[1]);
+			if(*replaceLink == (GmOsChunkNodeTree*)dlInfo::nullChunkAddress) 
+				replaceLink = &(node -> child[0]);
+			if(*replaceLink != (GmOsChunkNodeTree*)dlInfo::nullChunkAddress) {
+				replace = *replaceLink;
+				for(;;) {
+					GmOsChunkNodeTree** childLink = &(replace -> child[1]);
+					if(*childLink == (GmOsChunkNodeTree*)dlInfo::nullChunkAddress)
+						childLink = &(replace -> child[0]);
+					if(*childLink == (GmOsChunkNodeTree*)dlInfo::nullChunkAddress) break;
+					replaceLink = childLink;
+					replace = *childLink;
+				}
+				*replaceLink = (GmOsChunkNodeTree*)dlInfo::nullChunkAddress;
+			}
+		}
+		
+		// Replace the chunk in the trie, if it is not a peer.
+		if(parent != (GmOsChunkNodeTree*)dlInfo::nullChunkAddress) {
+			if(tree[node -> index] == node) {
+				tree[node -> index] = replace;
+				if(replace == (GmOsChunkNodeTree*)dlInfo::nullChunkAddress) 
+					treeMap &= ~(1u << node -> index);
+			}
+			else parent -> child[(parent -> child[0] == node)? 0 : 1] = replace;
+			
+			if(replace != (GmOsChunkNodeTree*)dlInfo::nullChunkAddress) {
+				replace -> parent = parent;
+				for(orderType side = 0; side < 2; ++ side) {
+					if(node -> child[side] == (GmOsChunkNodeTree*)dlInfo::nullChunkAddress) continue;
+					replace -> child[side] = node -> child[side];
+					node -> child[side] -> parent = replace;
+				}
+			}
+		}
+		
+		// The chunk is no longer in any bin.
+		node -> next = node -> previous = (GmOsChunkNodeSmall*)dlInfo::nullChunkAddress;
+		node -> index = treeBinNone;
+	}
+	
+	/// Find the best fit chunk for the size in the tree bins, or null if there's no 
+	/// chunk large enough. The chunk found is not unlinked.
+	chunkType searchTreeChunk(allocateSizeType size) noexcept {
+		GmOsChunkNodeTree* best = (GmOsChunkNodeTree*)dlInfo::nullChunkAddress;
+		GmOsChunkNodeTree* current = (GmOsChunkNodeTree*)dlInfo::nullChunkAddress;
+		allocateSizeType bestRemain = ~size + 1;
+		orderType index = treeIndexOf(size);
+		
+		// Walk down the trie by the key bits of size, recording the best fit on the 
+		// path, and the deepest right subtree that is not walked into, whose chunks
+		// are all larger than the size.
+		if(size >= (1 << dlInfo::smallbinMaxOrder) && 
+			tree[index] != (GmOsChunkNodeTree*)dlInfo::nullChunkAddress) {
+			current = tree[index];
+			GmOsChunkNodeTree* largerSubtree = (GmOsChunkNodeTree*)dlInfo::nullChunkAddress;
+			allocateSizeType key = size << treeShiftOf(index);
+			for(;;) {
+				allocateSizeType remain = chunkOf(current) -> size() - size;
+				if(remain < bestRemain) {
+					best = current; bestRemain = remain;
+					if(remain == 0) break;
+				}
+				GmOsChunkNodeTree* right = current -> child[1];
+				current = current -> child[key >> (sizeBits - 1)];
+				if(right != (GmOsChunkNodeTree*)dlInfo::nullChunkAddress && right != current) 
+					largerSubtree = right;
+				if(current == (GmOsChunkNodeTree*)dlInfo::nullChunkAddress) {
+					current = largerSubtree;
+					break;
+				}
+				key <<= 1;
+			}
+		}
+		
+		// Otherwise all chunks of the next non-empty tree bin are larger.
+		if(best == (GmOsChunkNodeTree*)dlInfo::nullChunkAddress && 
+			current == (GmOsChunkNodeTree*)dlInfo::nullChunkAddress) {
+			unsigned int largerBins = (size >= (1 << dlInfo::smallbinMaxOrder))? 
+				treeMap & ~((2u << index) - 1) : treeMap;
+			if(largerBins != 0) {
+				index = 0;
+				for(; (largerBins & (1u << index)) == 0; ++ index);
+				current = tree[index];
+			}
+		}
+		
+		// Find the smallest chunk of the subtree, through the leftmost path.
+		while(current != (GmOsChunkNodeTree*)dlInfo::nullChunkAddress) {
+			allocateSizeType remain = chunkOf(current) -> size() - size;
+			if(remain < bestRemain) { best = current; bestRemain = remain; }
+			current = current -> leftmostChild();
+		}
+		return chunkOf(best);
+	}
+	
 	/// Insert the chunk into proper bin. The chunk is assumed not to link with any bin node, but will be 
 	/// linked after arranging. (Will always find some where to insert the chunk).
 	void arrangeChunk(chunkType chunk) noexcept {
@@ -295,86 +532,17 @@ struct GmOsFineAllocatorDlMalloc {
 		// Judge by the size.
 		if(size >= sizeof(GmOsChunkNodeSmall)) {
 			
-			// Insert the chunk into the fast bin.
-			if(size < (1 << dlInfo::fastbinMaxOrder)) {
-				orderType fastOrder = 2;
-				for(; ((1 << fastOrder) < sizeof(GmOsChunkNodeSmall)) 
-							|| (1 << (fastOrder + 1)) < size; ++ fastOrder);
-				fast[fastOrder].insertSmallAfter(&(chunk -> payload.small));
-				return;
-			}
-			
-			// Insert the chunk into small bin.
-			else if(size < (1 << dlInfo::smallbinMaxOrder)) {
-				orderType smallOrder = dlInfo::fastbinMaxOrder;
-				for(; (1 << (smallOrder + 1)) < size; ++ smallOrder);
-				GmOsChunkNodeSmall* nodePrevious = &small[smallOrder - dlInfo::fastbinMaxOrder];
-				GmOsChunkNodeSmall* nodeCurrent = nodePrevious -> next;
-				
-				// See whether the chunk might be inserted in the center.
-				while(nodeCurrent != (GmOsChunkNodeSmall*)dlInfo::nullChunkAddress) {
-					chunkType chunkCurrent = chunkOf(nodeCurrent);
-					
-					// Insert the chunk right before this chunk.
-					if(chunkCurrent -> size() >= size) {
-						nodeCurrent -> insertSmallBefore(&(chunk -> payload.small));
-						return;
-					}
-					
-					// Just go forward.
-					else {
-						nodePrevious = nodeCurrent;
-						nodeCurrent = nodeCurrent -> next;
-					}
-				}
-					
-				// The chunk will be inserted at last.
-				nodePrevious -> insertSmallAfter(&(chunk -> payload.small));
+			// Push the chunk into the small bin of its size.
+			if(size < (1 << dlInfo::smallbinMaxOrder)) {
+				unsigned int index = size >> smallBinShift;
+				smallBinNode(index) -> insertSmallAfter(&(chunk -> payload.small));
+				smallMap[index / smallMapBits] |= (1u << (index % smallMapBits));
 				return;
 			}
 			
-			// Insert the chunk into large bin.
-			else if(size < (1 << dlInfo::pageSizeShift)) {
-				orderType largeOrder = dlInfo::smallbinMaxOrder;
-				for(; (1 << (largeOrder + 1)) < size; ++ largeOrder);
-				GmOsChunkNodeLarge* nodePrevious = &large[largeOrder - dlInfo::smallbinMaxOrder];
-				GmOsChunkNodeLarge* nodeCurrent = nodePrevious -> nextSize;
-				GmOsChunkNodeLarge* nodeChunk = &(chunk -> payload.large);
-				
-				// See whether the chunk might be inserted in the center.
-				while(nodeCurrent != (GmOsChunkNodeLarge*)dlInfo::nullChunkAddress) {
-					chunkType chunkCurrent = chunkOf(nodeCurrent);
-					
-					// Insert the chunk as a standalone chunk of this chunk.
-					if(chunkCurrent -> size() > size) {
-						nodeCurrent -> insertSmallBefore(nodeChunk);
-						chunk -> payload.large.nextSize = nodeCurrent;
-						chunk -> payload.large.previousSize = nodePrevious;
-						nodePrevious -> nextSize = nodeChunk;
-						nodeCurrent -> previousSize = nodeChunk;
-						return;
-					}
-					
-					// Insert the chunk as a buddy of this chunk.
-					else if(chunkCurrent -> size() == size) {
-						nodeCurrent -> insertSmallAfter(nodeChunk);
-						nodeChunk -> nextSize = nodeChunk -> previousSize 
-							= (GmOsChunkNodeLarge*)dlInfo::nullChunkAddress;
-						return;
-					}
-					
-					// Just go forward.
-					else {
-						nodePrevious = nodeCurrent;
-						nodeCurrent = nodeCurrent -> nextSize;
-					}
-				}
-				
-				// The chunk will be inserted at last.
-				nodePrevious -> insertSmallAfter(nodeChunk);
-				nodeChunk -> previousSize = nodePrevious;
-				nodePrevious -> nextSize = nodeChunk;
-				nodeChunk -> nextSize = (GmOsChunkNodeLarge*)dlInfo::nullChunkAddress;
+			// Insert the chunk into tree bin.
+			else {
+				insertTreeChunk(chunk);
 				return;
 			}
 		}
@@ -383,10 +551,16 @@ struct GmOsFineAllocatorDlMalloc {
 		unsorted.insertSmallAfter(&(chunk -> payload.small));
 	}
 	
-	/// Safely unlink a chunk based on its size trait.
-	static inline void safelyUnlinkChunk(chunkType chunk) noexcept {
-		if(chunk -> isLargeChunkSize()) 
-			chunk -> payload.large.unlinkChunk();
+	/// Insert the chunk into the unsorted bin, marking the large chunk not in tree bin.
+	inline void insertUnsortedChunk(chunkType chunk) noexcept {
+		if(chunk -> isLargeChunkSize()) chunk -> payload.tree.index = treeBinNone;
+		unsorted.insertSmallAfter(&(chunk -> payload.small));
+	}
+	
+	/// Safely unlink a chunk based on its size trait and the bin it lies in.
+	inline void safelyUnlinkChunk(chunkType chunk) noexcept {
+		if(chunk -> isLargeChunkSize() && chunk -> payload.tree.index != treeBinNone) 
+			unlinkTreeChunk(chunk);
 		else chunk -> payload.small.unlinkChunk();
 	}
 	
@@ -405,16 +579,8 @@ struct GmOsFineAllocatorDlMalloc {
 		if(GmOsFineChunkDlMalloc::physicalSize(sizeof(GmOsChunkNodeSmall)) <= availableSize) {
 			chunkSizeType remainedSize = 0;
 			
-			// We can safely make it a small or large chunk, or even more.
-			if(availableSize >= GmOsFineChunkDlMalloc::physicalSize(1 << dlInfo::fastbinMaxOrder))
-				remainedSize = availableSize - GmOsFineChunkDlMalloc::payloadOffset;
-			
-			// We will have to search for a safe size that we can make it a chunk.
-			else {
-				remainedSize = 1 << (dlInfo::fastbinMaxOrder - 1);
-				while(GmOsFineChunkDlMalloc::physicalSize(remainedSize) > availableSize 
-					&& remainedSize > 0) remainedSize >>= 1;
-			}
+			// Any chunk holding the node could be binned, as the small bins are exact.
+			remainedSize = availableSize - GmOsFineChunkDlMalloc::payloadOffset;
 			
 			// Perform chunk splitting.
 			if(remainedSize > 0) {
@@ -423,8 +589,8 @@ struct GmOsFineAllocatorDlMalloc {
 				nextChunk -> previousSize = remainedSize;
 				chunkType splittedChunk = nextChunk -> previousPhysicalChunk();
 				
-				// Prepare data for the splitted chunk.
-				splittedChunk -> chunkSize = remainedSize;
+				// Prepare data for the splitted chunk, whose previous chunk is in use.
+				splittedChunk -> chunkSize = remainedSize | GmOsFineChunkDlMalloc::bitPreviousInUse;
 				chunkSizeType updatedSize = chunk -> size() - splittedChunk -> physicalSize();
 				splittedChunk -> previousSize = updatedSize;
 				chunk -> updateSize(updatedSize);
@@ -449,7 +615,7 @@ struct GmOsFineAllocatorDlMalloc {
 	/// (After)        | Previous | ChunkSize'' | ---------------------------------------- | ChunkSize'' |
 	///  BeforeCurrent A                                                           Current A
 	/// Where, ChunkSize'' = ChunkSize + ChunkSize' + 2 * sizeof(chunkSizeType).
-	static chunkType coalsceChunkBefore(chunkType chunk) noexcept {
+	chunkType coalsceChunkBefore(chunkType chunk) noexcept {
 		// No node will be unlinked under such situation.
 		if(chunk -> previousInUse()) return (chunkType)dlInfo::nullChunkAddress;
 		
@@ -484,7 +650,7 @@ struct GmOsFineAllocatorDlMalloc {
 	/// (After)        | Previous | ChunkSize'' | ---------------------------------------- | ChunkSize'' |
 	///        Current A                                                      AfterCurrent A
 	/// Where, ChunkSize'' = ChunkSize + ChunkSize' + 2 * sizeof(chunkSizeType).
-	static inline void coalsceChunkAfter(chunkType chunk) noexcept {
+	inline void coalsceChunkAfter(chunkType chunk) noexcept {
 		chunkType visitingChunk = chunk -> nextPhysicalChunk();
 		while(!visitingChunk -> currentInUse()) {
 			// assert(visitingChunk != topChunk, "Invariant violation in dlmalloc allocator!");
@@ -502,40 +668,46 @@ struct GmOsFineAllocatorDlMalloc {
 		}
 	}
 	
-	/// Coalsce chunks into a bigger one. The final coalscing result will be relinked. The chunk 
-	/// being coalsced is assumed to be inside the unsorted bin.
-	static inline chunkType coalsceChunkUnsorted(chunkType chunk) noexcept {
-		chunkType result = chunk;
-		chunkType coalscedPrevious = coalsceChunkBefore(chunk);
+	/// Coalsce chunks into a bigger one. The chunk being coalsced is assumed to have been 
+	/// taken off the free list, and the coalscing result will not be linked into any bin.
+	chunkType coalsceChunk(chunkType chunk) noexcept {
+		chunkType result = coalsceChunkBefore(chunk);
 		
-		// Some chunk before the specified chunk was coalsced.
-		if(coalscedPrevious != (chunkType)dlInfo::nullChunkAddress) {
-			result = coalscedPrevious;
-			
-			// Replace the chunk with the coalsced result chunk.
-			result -> payload.small.next = chunk -> payload.small.next;
-			chunkOf(chunk -> payload.small.next) -> payload.small.previous = &(result -> payload.small);
-			result -> payload.small.previous = chunk -> payload.small.previous;
-			chunkOf(chunk -> payload.small.previous) -> payload.small.next = &(result -> payload.small);
-			chunk -> payload.small.next = chunk -> payload.small.previous = 
-				(GmOsChunkNodeSmall*)dlInfo::nullChunkAddress;
-		}
-		
-		// Coalsce the result forward.
+		// The chunk will be coalsced forward into the chunks before.
+		if(result == (chunkType)dlInfo::nullChunkAddress) result = chunk;
 		coalsceChunkAfter(result);
 		
+		// Detach the result from any bin.
+		result -> payload.small.next = result -> payload.small.previous = 
+			(GmOsChunkNodeSmall*)dlInfo::nullChunkAddress;
+		if(result -> isLargeChunkSize()) result -> payload.tree.index = treeBinNone;
 		return result;
 	}
 	
+	/// The bytes occupied by an allocated chunk, including its header.
+	static inline allocateSizeType chunkUsage(chunkType chunk) noexcept {
+		if(chunk -> isPageAllocated()) 
+			return ((allocateSizeType)1 << dlInfo::pageSizeShift) << (chunk -> size() >> 2);
+		return chunk -> physicalSize();
+	}
+	
 	/// Attempt to allocate a chunk. If no chunk can be allocated, the null address will 
 	/// be returned.
 	void* allocate(allocateSizeType size) noexcept {
+		void* memory = allocateChunk(size);
+		if(dlInfo::collectStatistics && memory != nullptr) 
+			this -> increaseUsage(chunkUsage(chunkOf(memory)));
+		return memory;
+	}
+	
+	/// Allocate a chunk from the bins, the top chunk or the page allocator.
+	void* allocateChunk(allocateSizeType size) noexcept {
 		// Round up the size.
 		if(size < sizeof(GmOsChunkNodeSmall)) size = sizeof(GmOsChunkNodeSmall);
 		else size = ((size + 0x03) | 0x03) ^ 0x03;
 		
 		// Eliminate impossible allocation.
-		if(size >= ((dlInfo::totalPageFrame()) << dlInfo::pageSizeShift)) return nullptr;
+		if(size >= ((pageAllocator.totalPageFrame()) << dlInfo::pageSizeShift)) return nullptr;
 		
 		// Judge whether the allocation level is page level.
 		allocateSizeType physicalSize = GmOsFineChunkDlMalloc::physicalSize(size);
@@ -552,8 +724,7 @@ struct GmOsFineAllocatorDlMalloc {
 			
 			// Initialize page chunk header now.
 			chunkType chunk = reinterpret_cast<chunkType>(page);
-			chunk -> updateSize(orderSize << 2);
-			chunk -> setFlag(GmOsFineChunkDlMalloc::bitPageAllocated);
+			chunk -> chunkSize = (orderSize << 2) | GmOsFineChunkDlMalloc::bitPageAllocated;
 			return chunk -> payload.memory;
 		}
 		
@@ -561,118 +732,33 @@ struct GmOsFineAllocatorDlMalloc {
 		else {
 			if(!topChunkInitialize()) return nullptr;
 			
-			// Search in the fast bin for a potential chunk.
-			// The bin will be directly allocated once a bin of fitting is found. Regardless
-			// of internal fragment. This will surely increase the efficiency.
-			if(size < (1 << dlInfo::fastbinMaxOrder)) {
-				// Find the start fast order to allocate.
-				orderType fastOrder = 2;
-				for(; ((1 << fastOrder) < sizeof(GmOsChunkNodeSmall)) 
-						|| (1 << fastOrder) > size; ++ fastOrder);
-				
-				// Search for a chunk in the fast bin.
-				for(; fastOrder < dlInfo::fastbinMaxOrder; ++ fastOrder)
-					if(fast[fastOrder].next != (GmOsChunkNodeSmall*)dlInfo::nullChunkAddress) {
-						
-						// Get that chunk directly and return it to user.
-						chunkType chunk = chunkOf(fast[fastOrder].next);
-						chunk -> payload.small.unlinkChunk();
-						chunk -> nextPhysicalChunk() -> setFlag(GmOsFineChunkDlMalloc::bitPreviousInUse);
-						return chunk -> payload.memory;
-					}
-			}
-			
-			// Search in the small bin for a potential chunk.
+			// Pop the chunk from the small bin of the size, or the next non-empty one.
+			// The chunk of the next bin will be splitted if the remainder could be binned.
 			if(size < (1 << dlInfo::smallbinMaxOrder)) {
-				// Find the start small order to allocate.
-				orderType smallOrder = dlInfo::fastbinMaxOrder;
-				for(; (1 << (smallOrder + 1)) > size; ++ smallOrder);
-				
-				// Search for a small chunk in the bin.
-				for(; smallOrder < dlInfo::smallbinMaxOrder; ++ smallOrder) {
-					orderType order = smallOrder - dlInfo::fastbinMaxOrder;
-					
-					// Find the best fit bin, and return the splitted chunk.
-					chunkType current = chunkOf(small[order].next);
-					for(; current != (chunkType)dlInfo::nullChunkAddress; 
-						current = chunkOf(current -> payload.small.next)) {
-						if(current -> size() >= size) {
-							current -> payload.small.unlinkChunk();
-							return splitUseChunk(current, size);
-						}
-					}
+				chunkType chunk = searchSmallChunk(size);
+				if(chunk != (chunkType)dlInfo::nullChunkAddress) {
+					chunk -> payload.small.unlinkChunk();
+					return splitUseChunk(chunk, size);
 				}
 			}
 			
-			// Search in the fast bin for a potential chunk.
+			// Search in the tree bins for the best fit chunk.
 			{
-				// Find the start large order to allocate.
-				orderType largeOrder = dlInfo::smallbinMaxOrder;
-				for(; (1 << (largeOrder + 1)) > size; ++ largeOrder);
-				
-				// Search for a large chunk in the bin.
-				for(; largeOrder < dlInfo::pageSizeShift; ++ largeOrder) {
-					orderType order = largeOrder - dlInfo::smallbinMaxOrder;
-					
-					// Find the best fit bin, and return the splitted chunk.
-					chunkType current = chunkOf(large[order].nextSize);
-					for(; current != (chunkType)dlInfo::nullChunkAddress; 
-							current = chunkOf(current -> payload.large.nextSize)) {
-
-						if(current -> size() >= size) {
-							// Always use the next chunk of current if possible.
-							if(current -> payload.large.next != current -> payload.large.nextSize) {
-								chunkType nextChunk = chunkOf(current -> payload.large.next);
-								nextChunk -> payload.large.unlinkChunk();
-								return splitUseChunk(nextChunk, size);
-							}
-							
-							// Well, we have to use this chunk.
-							else {
-								current -> payload.large.unlinkChunk();
-								return splitUseChunk(current, size);
-							}
-						}
-					}
+				chunkType chunk = searchTreeChunk(size);
+				if(chunk != (chunkType)dlInfo::nullChunkAddress) {
+					unlinkTreeChunk(chunk);
+					return splitUseChunk(chunk, size);
 				}
 			}
 			
-			// The chunk will be returned if it is selected.
-			chunkType selectedChunk = (chunkType)dlInfo::nullChunkAddress;
-			
-			// Find in the unsorted bin and coalse the chunk if possible.
-			if(unsorted.next != (GmOsChunkNodeSmall*)dlInfo::nullChunkAddress) {
-				for(chunkType chunk = chunkOf(unsorted.next);
-					chunk != (chunkType)dlInfo::nullChunkAddress; ) {
-					
-					// Attempt to coalsce chunk. Please notice the coalscing process does not 
-					// remove the chunk from the current list.
-					chunkType coalsced = coalsceChunkUnsorted(chunk);
-					
-					// Now fetch the next node of the coalsced chunk.
-					chunkType nextChunk = chunkOf(coalsced -> payload.small.next);
-					coalsced -> payload.small.unlinkChunk();
-					
-					if(coalsced -> size() >= size) {
-						if(selectedChunk == (chunkType)dlInfo::nullChunkAddress) 
-							selectedChunk = coalsced;
-						else if(selectedChunk -> size() > coalsced -> size()) {
-							arrangeChunk(selectedChunk);
-							selectedChunk = coalsced;
-						}
-					}
-					
-					// Insert the coalsced chunk into a proper list, and forward to next chunk.
-					else arrangeChunk(coalsced);
-					
-					chunk = nextChunk;
-				}
-			}
-			
-			// Return the result if the coalsced chunk is suitable.
-			if(selectedChunk != (chunkType)dlInfo::nullChunkAddress) {
-				safelyUnlinkChunk(selectedChunk);
-				return splitUseChunk(selectedChunk, size);
+			// Find in the unsorted bin and coalse the chunk if possible. The first 
+			// coalsced chunk that fits will be used, and the others will be arranged.
+			while(unsorted.next != (GmOsChunkNodeSmall*)dlInfo::nullChunkAddress) {
+				chunkType chunk = chunkOf(unsorted.next);
+				chunk -> payload.small.unlinkChunk();
+				chunkType coalsced = coalsceChunk(chunk);
+				if(coalsced -> size() >= size) return splitUseChunk(coalsced, size);
+				arrangeChunk(coalsced);
 			}
 			
 			// Cannot allocate the page from free list, now split off the top chunk.
@@ -683,15 +769,14 @@ struct GmOsFineAllocatorDlMalloc {
 			// As the returned chunk will be in use, so the previous in use bit of the 
 			// new top chunk will always be set to true.
 			{ 
-				if(physicalSize > topChunk -> size()) increaseTopChunk();
+				if(!increaseTopChunk(physicalSize)) return nullptr;
 				chunkSizeType remainedSize = topChunk -> size() - physicalSize;
 				topChunk -> updateSize(size);
 				chunkType returnedChunk = topChunk;
 				
 				topChunk = topChunk -> nextPhysicalChunk();
 				topChunk -> previousSize = size;
-				topChunk -> updateSize(remainedSize);
-				topChunk -> setFlag(GmOsFineChunkDlMalloc::bitPreviousInUse);
+				topChunk -> chunkSize = remainedSize | GmOsFineChunkDlMalloc::bitPreviousInUse;
 				return returnedChunk -> payload.memory;
 			}
 		}
@@ -701,6 +786,7 @@ struct GmOsFineAllocatorDlMalloc {
 	void deallocate(void* memory) noexcept {
 		if(memory == nullptr) return;
 		chunkType chunk = chunkOf(memory);
+		if(dlInfo::collectStatistics) this -> decreaseUsage(chunkUsage(chunk));
 		
 		/// Return the chunk in page back to the allocator.
 		if(chunk -> isPageAllocated()) {
@@ -710,18 +796,11 @@ struct GmOsFineAllocatorDlMalloc {
 		else {
 			if(!topChunkInitialize()) return;
 			
-			// Reset the chunk data to avoid potential data violation.
-			chunk -> payload.small.next = chunk -> payload.small.previous
-				= (GmOsChunkNodeSmall*)dlInfo::nullChunkAddress;
-			if(chunk -> isLargeChunkSize())
-				chunk -> payload.large.nextSize = chunk -> payload.large.previousSize
-					= (GmOsChunkNodeLarge*)dlInfo::nullChunkAddress;
-			
 			// Mark the current chunk as not allocated.
 			chunk -> nextPhysicalChunk() -> clearFlag(GmOsFineChunkDlMalloc::bitPreviousInUse);
 			
 			// Put the chunk inside the unsorted bin.
-			unsorted.insertSmallAfter(&(chunk -> payload.small));
+			insertUnsortedChunk(chunk);
 			
 			// Trigger top chunk shrink if adjacent.
 			if(!topChunk -> previousInUse()) {
@@ -729,9 +808,41 @@ struct GmOsFineAllocatorDlMalloc {
 				if(coalscedChunk != (chunkType)dlInfo::nullChunkAddress) {
 					coalscedChunk -> updateSize(coalscedChunk -> size() + topChunk -> physicalSize());
 					topChunk = coalscedChunk;
-					shrinkTopChunk();
+					if(topChunkFreePages() > dlInfo::trimThresholdPages) 
+						shrinkTopChunk(dlInfo::topPadPages);
 				}
 			}
 		}
 	}
+	
+	/// Retrieve the bytes in use and their peak, or 0 if the statistics are not collected.
+	inline allocateSizeType bytesInUse() const noexcept { return this -> currentUsage(); }
+	inline allocateSizeType peakBytesInUse() const noexcept { return this -> peakUsage(); }
+	
+	/// Count the chunks linked after the bin head, accumulating their number, bytes 
+	/// and the largest size.
+	static void countBin(const GmOsChunkNodeSmall& bin, allocateSizeType& chunks, 
+		allocateSizeType& bytes, allocateSizeType& largest) noexcept {
+		for(GmOsChunkNodeSmall* node = bin.next; node != 
+			(GmOsChunkNodeSmall*)dlInfo::nullChunkAddress; node = node -> next) {
+			chunkSizeType size = chunkOf(node) -> size();
+			++ chunks; bytes += size;
+			if(size > largest) largest = size;
+		}
+	}
+	
+	/// Count the chunks in the subtree of a tree bin, including the peers of each node.
+	static void countTree(const GmOsChunkNodeTree* node, allocateSizeType& chunks, 
+		allocateSizeType& bytes, allocateSizeType& largest) noexcept {
+		if(node == (const GmOsChunkNodeTree*)dlInfo::nullChunkAddress) return;
+		const GmOsChunkNodeSmall* peer = node;
+		do {
+			chunkSizeType size = chunkOf(const_cast<GmOsChunkNodeSmall*>(peer)) -> size();
+			++ chunks; bytes += size;
+			if(size > largest) largest = size;
+			peer = peer -> next;
+		} while(peer != node);
+		countTree(node -> child[0], chunks, bytes, largest);
+		countTree(node -> child[1], chunks, bytes, largest);
+	}
 };
\ No newline at end of file
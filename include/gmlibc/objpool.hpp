@@ -0,0 +1,186 @@
+#pragma once
+/**
+ * @file gmlibc/objpool.hpp
+ * @brief Typed Object Pool with Generation-Checked Handles
+ * @author Haoran Luo
+ *
+ * This pool constructs typed objects inside a slob allocator, whose object
+ * size is derived at compile time. The objects are referred by 16-bit handles
+ * instead of raw pointers, so that a handle referring to a destroyed object
+ * could be detected rather than accessing the reused memory.
+ *
+ * A handle is composed of the index of a slot and the generation of the slot.
+ * The generation of a slot increases every time its object is destroyed, and
+ * the handle whose generation mismatches is regarded stale. The generation 0
+ * is never used, so the handle 0 always refers to no object.
+ *
+ * Handle                       Slot Table            Dense Table
+ * +------------+-------+       +------------+-----+  +---------+------+
+ * | Generation | Index | ----> | Generation | Pos | -> | Object* | Slot |
+ * +------------+-------+       +------------+-----+  +---------+------+
+ *
+ * The live objects are also recorded in a dense table, which is kept compact
+ * by moving the last entry to the hole on destruction. So iterating over live
+ * objects is iterating over a contiguous array of pointers, without walking
+ * the slob frames.
+ */
+#include "gmlibc/slob.hpp"
+#include <new>
+
+template<typename T, typename slobInfo, typename pageAllocatorType,
+	unsigned short maxObjects, typename pagePolicyType = GmOsSlobPagePolicyNaiveSingle<slobInfo> >
+struct GmOsObjectPool {
+	/// Forward template types ahead.
+	typedef typename slobInfo::addressType addressType;
+	typedef typename slobInfo::objectNumberType objectNumberType;
+
+	/// The handle referring to the object.
+	typedef unsigned short handleType;
+	static constexpr handleType nullHandle = 0;
+
+	/// The number of bits of the slot index in handle, and the rest bits are
+	/// used for generation.
+	static constexpr unsigned int bitsFor(unsigned int value) noexcept {
+		return value <= 1? 0 : 1 + bitsFor((value + 1) >> 1);
+	}
+	static constexpr unsigned int indexBits = bitsFor(maxObjects);
+	static constexpr unsigned int generationBits = 16 - indexBits;
+	static_assert(maxObjects > 0 && generationBits >= 4,
+		"Too many objects in the pool to keep the handles 16-bit.");
+	static constexpr handleType indexMask = (1 << indexBits) - 1;
+	static constexpr handleType generationMask = (1 << generationBits) - 1;
+
+	/// The object size derived from the type, which is aligned to word and could
+	/// hold the free list of slob.
+	static_assert(alignof(T) <= sizeof(addressType),
+		"The alignment of object is not supported by the slob allocator.");
+	static constexpr unsigned int objectSize =
+		((sizeof(T) < sizeof(objectNumberType)? sizeof(objectNumberType) : sizeof(T))
+		+ sizeof(addressType) - 1) / sizeof(addressType) * sizeof(addressType);
+
+	/// The slob allocator holding the objects.
+	typedef GmOsSlobRuntimeStaticSized<slobInfo, objectSize, pagePolicyType> runtimeType;
+	typedef GmOsFineAllocatorSlob<slobInfo, pageAllocatorType, runtimeType> slobType;
+	slobType slob;
+
+	/// The slot referred by the handle. While the slot is in use, the position is
+	/// the index of its object in the dense table, otherwise the position is the
+	/// next free slot.
+	struct GmOsObjectSlot {
+		handleType generation;
+		unsigned short position;
+	};
+	GmOsObjectSlot slots[maxObjects];
+
+	/// The dense table of the live objects and their slots.
+	T* objects[maxObjects];
+	unsigned short objectSlots[maxObjects];
+
+	/// The number of live objects and the first free slot.
+	unsigned short count, freeSlot;
+
+	/// Constructor for the object pool.
+	GmOsObjectPool(pageAllocatorType& pageAllocator) noexcept:
+		slob(pageAllocator, runtimeType()), count(0), freeSlot(0) {
+		for(unsigned short i = 0; i < maxObjects; ++ i) {
+			slots[i].generation = 1;
+			slots[i].position = i + 1;
+		}
+	}
+
+	/// Destroy all live objects while destructing the pool.
+	~GmOsObjectPool() noexcept { clear(); }
+
+	/// Compose and decompose the handle.
+	static inline handleType handleFrom(unsigned short slot, handleType generation) noexcept {
+		return (generation << indexBits) | slot;
+	}
+
+	static inline unsigned short slotOf(handleType handle) noexcept {
+		return handle & indexMask;
+	}
+
+	static inline handleType generationOf(handleType handle) noexcept {
+		return (handle >> indexBits) & generationMask;
+	}
+
+	/// Retrieve the object referred by the handle, or null if the handle is stale.
+	/// The generation of a free slot might match a forged or wrapped handle, but
+	/// its position is the next free slot, which never refers back to the slot.
+	T* get(handleType handle) const noexcept {
+		unsigned short slot = slotOf(handle);
+		if(slot >= maxObjects) return nullptr;
+		if(slots[slot].generation != generationOf(handle)) return nullptr;
+		unsigned short position = slots[slot].position;
+		if(position >= count || objectSlots[position] != slot) return nullptr;
+		return objects[position];
+	}
+
+	/// Check whether the handle refers to a live object.
+	inline bool valid(handleType handle) const noexcept {
+		return get(handle) != nullptr;
+	}
+
+	/// Construct an object in the pool, and return its handle, or null handle
+	/// if the pool or the slob allocator is exhausted.
+	template<typename... argumentTypes>
+	handleType create(argumentTypes&&... arguments) noexcept {
+		if(freeSlot >= maxObjects) return nullHandle;
+		void* memory = slob.allocate();
+		if(memory == nullptr) return nullHandle;
+		T* object = new (memory) T(static_cast<argumentTypes&&>(arguments)...);
+
+		// Take the free slot and append the object to the dense table.
+		unsigned short slot = freeSlot;
+		freeSlot = slots[slot].position;
+		slots[slot].position = count;
+		objects[count] = object;
+		objectSlots[count] = slot;
+		++ count;
+		return handleFrom(slot, slots[slot].generation);
+	}
+
+	/// Destroy the object referred by the handle. Stale handles are ignored.
+	void destroy(handleType handle) noexcept {
+		T* object = get(handle);
+		if(object == nullptr) return;
+		unsigned short slot = slotOf(handle);
+
+		// Move the last object in the dense table to the hole.
+		unsigned short position = slots[slot].position;
+		-- count;
+		if(position != count) {
+			objects[position] = objects[count];
+			objectSlots[position] = objectSlots[count];
+			slots[objectSlots[position]].position = position;
+		}
+
+		// Invalidate the handles and return the slot, skipping generation 0.
+		handleType generation = (slots[slot].generation + 1) & generationMask;
+		slots[slot].generation = (generation == 0)? 1 : generation;
+		slots[slot].position = freeSlot;
+		freeSlot = slot;
+
+		object -> ~T();
+		slob.deallocate(object);
+	}
+
+	/// Destroy all live objects in the pool.
+	void clear() noexcept {
+		while(count > 0) destroy(handleAt(count - 1));
+	}
+
+	/// Retrieve the number of live objects.
+	inline unsigned short size() const noexcept { return count; }
+
+	/// Retrieve the handle of the live object at the position of the dense table.
+	inline handleType handleAt(unsigned short position) const noexcept {
+		unsigned short slot = objectSlots[position];
+		return handleFrom(slot, slots[slot].generation);
+	}
+
+	/// Iterate over the live objects. Creating objects while iterating is safe,
+	/// but destroying objects changes the order of objects after the position.
+	inline T* const* begin() const noexcept { return objects; }
+	inline T* const* end() const noexcept { return objects + count; }
+};
@@ -16,7 +16,7 @@
  * +--------------+                    +-----------------+
  * | PartialFrame | -----------------> | FrameUsed       |
  * +--------------+                    +-----------------+
- * | FreeFrame    | <-- At most one.   | FrameTop        |
+ * | FreeFrame    | <-- Retained.      | FrameTop        |
  * +--------------+                    +-----------------+
  * | Slob Info    |                    | FrameFree       |
  * +--------------+                    +-----------------+
@@ -32,19 +32,24 @@
  * When a slob object is freed. We will search by validating whether
  * the page header magic check succeed. If succeed, the slob will be 
  * returned to this slob frame, and its slob frame will be promoted
- * or demoted. If the page frame is demoted and there's already some 
- * existing page frame. The lower address page frame will be deallocated,
- * and the higher address page frame will take the place.
+ * or demoted. The demoted page frames are retained in the free list. Once
+ * the number of retained frames exceeds the high watermark, the lower 
+ * address page frames will be deallocated until the number falls to the
+ * low watermark, so that a pool oscillating around a frame boundary will 
+ * not allocate and deallocate pages repeatedly.
  *
  * How large is the page frame to allocate purely depends on slob 
  * information.
  *
  * (The slob info is privately inherited so that empty object optimization
- * could be easily performed.)
+ * could be easily performed. So is the counter of live objects and their peak,
+ * which is empty unless slobInfo::collectStatistics is set.)
  */
+#include "gmlibc/counter.hpp"
 
 template<typename slobInfo, typename pageAllocatorType, typename slobRuntimeInfo>
-struct GmOsFineAllocatorSlob : private slobRuntimeInfo {
+struct GmOsFineAllocatorSlob : private slobRuntimeInfo, 
+	private GmOsUsageCounter<typename slobInfo::addressType, slobInfo::collectStatistics> {
 	typedef typename slobInfo::addressType addressType;
 	typedef typename slobInfo::objectNumberType objectNumberType;
 	typedef typename slobInfo::orderType orderType;
@@ -75,7 +80,7 @@ struct GmOsFineAllocatorSlob : private slobRuntimeInfo {
 		
 		/// The header size of the slob frame.
 		static constexpr addressType slobHeaderSize = 
-			reinterpret_cast<addressType>(&(((GmOsFineChunkSlob*)0x00) -> slobs));
+			__builtin_offsetof(GmOsFineChunkSlob, slobs);
 		
 		/// Calculate the magic word of the remained.
 		addressType expectedMagic(const slobRuntimeInfo& rti) const noexcept {
@@ -125,8 +130,43 @@ struct GmOsFineAllocatorSlob : private slobRuntimeInfo {
 			}
 		}
 		
-		/// Attempt return the object to the slob frame.
-		bool deallocateToFrame(const slobRuntimeInfo& rti, void* memory) noexcept {
+		/// Attempt to allocate at most (count) objects from the slob frame, and the
+		/// magic is synchronized once. The number of objects allocated is returned.
+		addressType allocateBulkFromFrame(const slobRuntimeInfo& rti, 
+			void** objects, addressType count) noexcept {
+			addressType capacity = rti.numObjects(slobHeaderSize, frameType);
+			addressType allocated = 0;
+			for(; allocated < count; ++ allocated) {
+				void* result;
+				if(freeHead != 0) {
+					// Directly pop the most recently freed object.
+					result = rti.offsetForObject(slobs, freeHead - 1);
+					freeHead = *((objectNumberType*)result);
+				}
+				else if(top < capacity) {
+					// Attempt to increase top from the frame.
+					result = rti.offsetForObject(slobs, top);
+					++ top;
+				}
+				else break;
+				objects[allocated] = result; ++ used;
+			}
+			if(allocated > 0) synchronizeMagic(rti);
+			return allocated;
+		}
+		
+		/// Determine whether the object lies inside the slob frame.
+		bool contains(const slobRuntimeInfo& rti, void* memory) const noexcept {
+			addressType thisAddress = reinterpret_cast<addressType>(this);
+			addressType memoryAddress = reinterpret_cast<addressType>(memory);
+			addressType frameSize = ((addressType)(1 << slobInfo::pageSizeShift))
+					<< rti.pageOrderOf(frameType);
+			return memoryAddress > thisAddress && memoryAddress - thisAddress < frameSize;
+		}
+		
+		/// Attempt return the object to the slob frame, without synchronizing the 
+		/// magic, which should be done after returning the objects.
+		bool releaseToFrame(const slobRuntimeInfo& rti, void* memory) noexcept {
 			// Make sure the deallocating object is valid.
 			objectNumberType* newFreeHead = (objectNumberType*)memory;
 			objectNumberType memoryIndex = rti.offsetFromObject(slobs, memory);
@@ -137,10 +177,22 @@ struct GmOsFineAllocatorSlob : private slobRuntimeInfo {
 			// Perform deallocation.
 			*newFreeHead = freeHead;
 			freeHead = memoryIndex + 1; -- used;
+			return true;
+		}
+		
+		/// Attempt return the object to the slob frame.
+		bool deallocateToFrame(const slobRuntimeInfo& rti, void* memory) noexcept {
+			if(!releaseToFrame(rti, memory)) return false;
 			synchronizeMagic(rti);
 			return true;
 		}
 		
+		/// Invalidate the header before the frame is returned to the page allocator,
+		/// so that the reused page will never be regarded as a slob frame.
+		inline void invalidate() noexcept {
+			magic = frameType = 0;
+		}
+		
 		/// Remove the frame from current list.
 		void removeFromList() noexcept {
 			if(previous != nullptr) *previous = next;
@@ -160,104 +212,223 @@ struct GmOsFineAllocatorSlob : private slobRuntimeInfo {
 	pageAllocatorType& pageAllocator;
 	GmOsFineChunkSlob *full, *partial, *sfree;
 	
+	// The number of retained free frames, and its low and high watermarks.
+	objectNumberType retained, retainLow, retainHigh;
+	
 	GmOsFineAllocatorSlob(pageAllocatorType& pageAllocator, const slobRuntimeInfo& rti): 
 		slobRuntimeInfo(rti), pageAllocator(pageAllocator), 
-		full(nullptr), partial(nullptr), sfree(nullptr) {}
+		full(nullptr), partial(nullptr), sfree(nullptr), retained(0),
+		retainLow(slobInfo::deftSlobDeallocate? 0 : 1),
+		retainHigh(slobInfo::deftSlobDeallocate? 0 : 1) {}
+	
+	/// Retrieve the runtime info, which is privately inherited.
+	inline const slobRuntimeInfo& runtimeInfo() const noexcept { return *this; }
+	
+	/// Ensure that there's some partial frame for allocation, or return false if no
+	/// more frame could be allocated.
+	bool preparePartial() noexcept {
+		if(partial != nullptr) return true;
+		if(sfree != nullptr) {
+			// Promote a free slob frame to the partial.
+			GmOsFineChunkSlob* popped = sfree;
+			popped -> removeFromList();
+			popped -> insertIntoList(&partial);
+			-- retained;
+		}
+		else {
+			// Initialize a new slob frame.
+			addressType frameType = slobRuntimeInfo::nextPageType(
+				GmOsFineChunkSlob::slobHeaderSize);
+			orderType order = slobRuntimeInfo::pageOrderOf(frameType);
+			GmOsFineChunkSlob* newSlobFrame = reinterpret_cast<
+				GmOsFineChunkSlob*>(pageAllocator.allocateHighPage(order));
+			if(newSlobFrame == (GmOsFineChunkSlob*)slobInfo::nullPageAddress) return false;
+			newSlobFrame -> frameType = frameType;
+			newSlobFrame -> used = newSlobFrame -> top = newSlobFrame -> freeHead = 0;
+			newSlobFrame -> insertIntoList(&partial);
+			newSlobFrame -> synchronizeMagic(*this);
+		}
+		return true;
+	}
+	
+	/// Move the top partial frame to the full list if it is full.
+	inline void promotePartial() noexcept {
+		if(partial -> full(*this)) {
+			GmOsFineChunkSlob* promoted = partial;
+			promoted -> removeFromList();
+			promoted -> insertIntoList(&full);
+		}
+	}
 	
 	/// Allocate new object.
 	void* allocate() noexcept {
 		// Ensure that there's some partial list for allocation.
-		if(partial == nullptr) {
-			if(sfree != nullptr) {
-				// Promote a free slob frame to the partial.
-				GmOsFineChunkSlob* popped = sfree;
-				popped -> removeFromList();
-				popped -> insertIntoList(&partial);
-			}
-			else {
-				// Initialize a new slob frame.
-				addressType frameType = slobRuntimeInfo::nextPageType();
-				orderType order = slobRuntimeInfo::pageOrderOf(frameType);
-				GmOsFineChunkSlob* newSlobFrame = reinterpret_cast<
-					GmOsFineChunkSlob*>(pageAllocator.allocateHighPage(order));
-				if(newSlobFrame == (GmOsFineChunkSlob*)slobInfo::nullPageAddress) return nullptr;
-				newSlobFrame -> frameType = frameType;
-				newSlobFrame -> used = newSlobFrame -> top = newSlobFrame -> freeHead = 0;
-				newSlobFrame -> insertIntoList(&partial);
-				newSlobFrame -> synchronizeMagic(*this);
-			}
-		}
+		if(!preparePartial()) return nullptr;
 		
 		// Allocate new object from the top partial frame.
 		void* result = partial -> allocateFromFrame(*this);
 		if(result == nullptr) return nullptr;
 		
 		// Update the partial frame status.
-		if(partial -> full(*this)) {
-			GmOsFineChunkSlob* promoted = partial;
-			partial -> removeFromList();
-			partial -> insertIntoList(&full);
-		}
+		promotePartial();
 		
 		// Notify that one object has been created.
 		slobRuntimeInfo::objectCreated();
+		this -> increaseUsage(1);
 		return result;
 	}
 	
-	/// Deallocate an object.
-	void deallocate(void* object) noexcept {
-		if(object == nullptr) return;
-		
-		// Determine which slab frame contains this object.
+	/// Allocate at most (count) objects into the array, filling from one partial 
+	/// frame at a time. The number of objects allocated is returned, which is less
+	/// than (count) only if no more frame could be allocated.
+	addressType allocateBulk(void** objects, addressType count) noexcept {
+		addressType allocated = 0;
+		while(allocated < count && preparePartial()) {
+			addressType filled = partial -> allocateBulkFromFrame(
+				*this, objects + allocated, count - allocated);
+			if(filled == 0) break;
+			allocated += filled;
+			promotePartial();
+			
+			// Notify that the objects have been created.
+			this -> increaseUsage(filled);
+			for(; filled > 0; -- filled) slobRuntimeInfo::objectCreated();
+		}
+		return allocated;
+	}
+	
+	/// Determine which slob frame contains this object, or null if not found.
+	GmOsFineChunkSlob* frameOf(void* object) noexcept {
 		addressType frameSize = (1 << slobInfo::pageSizeShift);
-		addressType firstPageAddress = slobInfo::firstPageAddress();
+		addressType firstPageAddress = pageAllocator.firstPageAddress();
 		addressType frameAddress = (((reinterpret_cast<addressType>(object)
 				- firstPageAddress) | (frameSize - 1)) ^ (frameSize - 1)) + firstPageAddress;
 		while(frameAddress >= firstPageAddress) {
 			if(reinterpret_cast<GmOsFineChunkSlob*>(frameAddress) -> isSlobHeader(*this)) break;
 			frameAddress -= frameSize;
 		}
-		if(frameAddress < firstPageAddress) return;
-		
-		// Perform deallocation.
-		GmOsFineChunkSlob* frame = reinterpret_cast<GmOsFineChunkSlob*>(frameAddress);
-		if(!frame -> deallocateToFrame(*this, object)) return;
+		if(frameAddress < firstPageAddress) return nullptr;
+		return reinterpret_cast<GmOsFineChunkSlob*>(frameAddress);
+	}
+	
+	/// Update the lists after objects have been returned to the frame.
+	void settleFrame(GmOsFineChunkSlob* frame, bool frameWasFull) noexcept {
+		/// The frame is no longer full, so it could be allocated from again.
+		if(frameWasFull) {
+			frame -> removeFromList();
+			frame -> insertIntoList(&partial);
+		}
 		
-		/// Check whether demotion should be performed.
+		/// Perform demotion, and trim the retained frames down to the low watermark
+		/// once they exceed the high watermark.
 		if(frame -> empty(*this)) {
-			if(slobInfo::deftSlobDeallocate) {
-				// Perform deallocation directly.
-				pageAllocator.freeHighPage(reinterpret_cast<pageType>(frame),
-							slobRuntimeInfo::pageOrderOf(frame -> frameType));
-			}
-			else {
-				// Perform demotion instead.
-				GmOsFineChunkSlob* demoted = frame;
-				demoted -> removeFromList();
-				if(sfree == nullptr) {
-					// Just replace the free list header.
-					demoted -> insertIntoList(&sfree);
-				}
-				else {
-					// One should be erased and one should take the place.
-					if(	reinterpret_cast<addressType>(demoted) > 
-						reinterpret_cast<addressType>(sfree)) {
-						pageAllocator.freeHighPage(reinterpret_cast<pageType>(sfree), 
-							slobRuntimeInfo::pageOrderOf(sfree -> frameType));
-						sfree = nullptr;
-						demoted -> insertIntoList(&sfree);
-					}
-					else {
-						pageAllocator.freeHighPage(reinterpret_cast<pageType>(demoted),
-							slobRuntimeInfo::pageOrderOf(demoted -> frameType));
-					}
-				}
-			}
+			frame -> removeFromList();
+			frame -> insertIntoList(&sfree);
+			++ retained;
+			if(retained > retainHigh) shrink(retainLow);
 		}
+	}
+	
+	/// Set the watermarks of the retained free frames. The low watermark will be
+	/// no greater than the high one, and the exceeding frames are trimmed at once.
+	void setRetention(objectNumberType low, objectNumberType high) noexcept {
+		retainHigh = high;
+		retainLow = (low > high)? high : low;
+		if(retained > retainHigh) shrink(retainLow);
+	}
+	
+	/// Deallocate the retained free frames until at most (keep) frames are retained,
+	/// where the lower address frames are deallocated first. The number of frames
+	/// deallocated is returned.
+	addressType shrink(objectNumberType keep = 0) noexcept {
+		addressType released = 0;
+		while(retained > keep && sfree != nullptr) {
+			GmOsFineChunkSlob* lowest = sfree;
+			for(GmOsFineChunkSlob* frame = sfree -> next; frame != nullptr; frame = frame -> next)
+				if(reinterpret_cast<addressType>(frame) < 
+					reinterpret_cast<addressType>(lowest)) lowest = frame;
+			lowest -> removeFromList();
+			orderType order = slobRuntimeInfo::pageOrderOf(lowest -> frameType);
+			lowest -> invalidate();
+			pageAllocator.freeHighPage(reinterpret_cast<pageType>(lowest), order);
+			-- retained; ++ released;
+		}
+		return released;
+	}
+	
+	/// Deallocate an object. False will be returned if the object does not lie in
+	/// any frame of the allocator, and nothing will be changed.
+	bool deallocate(void* object) noexcept {
+		if(object == nullptr) return true;
+		
+		// Determine which slab frame contains this object.
+		GmOsFineChunkSlob* frame = frameOf(object);
+		if(frame == nullptr) return false;
+		
+		// Perform deallocation.
+		bool frameWasFull = frame -> full(*this);
+		if(!frame -> deallocateToFrame(*this, object)) return false;
+		settleFrame(frame, frameWasFull);
 		
 		// Notify that one object has been destroyed.
 		slobRuntimeInfo::objectDestroyed();
+		this -> decreaseUsage(1);
+		return true;
 	}
+	
+	/// Deallocate the objects in the array. The consecutive objects of the same
+	/// frame are returned together, and the magic is synchronized once for them.
+	/// The number of objects deallocated is returned, excluding the null objects 
+	/// and the objects not in any frame of the allocator.
+	addressType deallocateBulk(void** objects, addressType count) noexcept {
+		GmOsFineChunkSlob* frame = nullptr;
+		bool frameWasFull = false, released = false;
+		addressType deallocated = 0;
+		for(addressType i = 0; i < count; ++ i) {
+			void* object = objects[i];
+			if(object == nullptr) continue;
+			
+			// Settle the previous frame before searching for another frame, so 
+			// that its magic will be valid while searching.
+			if(frame == nullptr || !frame -> contains(*this, object)) {
+				if(released) {
+					frame -> synchronizeMagic(*this);
+					settleFrame(frame, frameWasFull);
+					released = false;
+				}
+				frame = frameOf(object);
+				if(frame == nullptr) continue;
+				frameWasFull = frame -> full(*this);
+			}
+			
+			// Return the object without synchronizing the magic.
+			if(!frame -> releaseToFrame(*this, object)) continue;
+			released = true; ++ deallocated;
+			slobRuntimeInfo::objectDestroyed();
+			this -> decreaseUsage(1);
+		}
+		if(released) {
+			frame -> synchronizeMagic(*this);
+			settleFrame(frame, frameWasFull);
+		}
+		return deallocated;
+	}
+	
+	/// Count the frames in the list, accumulating the objects used in them and the
+	/// objects they could hold. The number of frames is returned.
+	addressType countFrames(const GmOsFineChunkSlob* list, 
+		addressType& used, addressType& capacity) const noexcept {
+		addressType frames = 0;
+		for(; list != nullptr; list = list -> next) {
+			++ frames; used += list -> used;
+			capacity += slobRuntimeInfo::numObjects(
+				GmOsFineChunkSlob::slobHeaderSize, list -> frameType);
+		}
+		return frames;
+	}
+	
+	/// Retrieve the peak of live objects, or 0 if the statistics are not collected.
+	inline addressType peakObjects() const noexcept { return this -> peakUsage(); }
 };
 
 /// @brief The page allocation that naively allocate pages no matter how many objects has 
@@ -269,7 +440,8 @@ struct GmOsSlobPagePolicyNaiveSingle {
 	typedef typename slobInfo::objectNumberType objectNumberType;
 	
 	/// Just single page will be accepted, and the page type is always deadbeef.
-	static addressType nextPageType() noexcept { return 0xdeadbeef; }
+	static addressType nextPageType(addressType slobHeaderSize, 
+		addressType objectSize) noexcept { return 0xdeadbeef; }
 	static bool isValidFrameType(addressType frameType) noexcept { return frameType == 0xdeadbeef; }
 	static orderType pageOrderOf(addressType frameType) noexcept { return 0; }
 	static addressType magicForType(addressType frameType) noexcept { return 0xcafebabe; }
@@ -279,6 +451,61 @@ struct GmOsSlobPagePolicyNaiveSingle {
 	static void objectDestroyed() noexcept {}
 };
 
+/// @brief The page allocation that adapts the frame order to the object size and the
+/// number of live objects. The frames of a small pool are single pages, and the frames
+/// grow as the pool grows so that a new frame could hold half of the live objects. Once
+/// the pool fills such a frame, the frame must also waste no more than 1/8 of its space.
+/// The frame order is encoded in the lowest bits of the frame type.
+template<typename slobInfo, unsigned int maxFrameOrder = 3>
+struct GmOsSlobPagePolicyAdaptive {
+	typedef typename slobInfo::orderType orderType;
+	typedef typename slobInfo::addressType addressType;
+	typedef typename slobInfo::objectNumberType objectNumberType;
+	
+	static_assert(maxFrameOrder < slobInfo::maxPageOrder && maxFrameOrder <= 0x0f,
+		"The frame order could not be allocated or encoded.");
+	
+	/// The frame type is the base ored with the frame order.
+	static constexpr addressType frameTypeBase = 0xadab1e00;
+	static constexpr addressType frameOrderMask = 0x0f;
+	
+	/// The number of live objects in the pool.
+	addressType liveObjects;
+	
+	GmOsSlobPagePolicyAdaptive() noexcept: liveObjects(0) {}
+	
+	/// Pick the smallest order fulfilling both the growth and the packing requirement.
+	/// The division is only performed when a new frame is required.
+	addressType nextPageType(addressType slobHeaderSize, addressType objectSize) const noexcept {
+		orderType order = 0;
+		for(; order < maxFrameOrder; ++ order) {
+			addressType usable = ((1 << slobInfo::pageSizeShift) << order) - slobHeaderSize;
+			addressType count = usable / objectSize;
+			if(count == 0 || (count << 1) < liveObjects) continue;
+			if(count <= liveObjects && ((usable - count * objectSize) << 3) > usable) continue;
+			break;
+		}
+		return frameTypeBase | order;
+	}
+	
+	static bool isValidFrameType(addressType frameType) noexcept {
+		return (frameType & ~frameOrderMask) == frameTypeBase
+			&& (frameType & frameOrderMask) <= maxFrameOrder;
+	}
+	
+	static orderType pageOrderOf(addressType frameType) noexcept { 
+		return frameType & frameOrderMask; 
+	}
+	
+	static addressType magicForType(addressType frameType) noexcept { 
+		return 0xcafebabe ^ frameType; 
+	}
+	
+	/// Count the live objects.
+	void objectCreated() noexcept { ++ liveObjects; }
+	void objectDestroyed() noexcept { -- liveObjects; }
+};
+
 /// @brief the runtime info where objects will be of 2 * n byte.
 template<typename slobInfo, typename sizeType, typename pagePolicyType>
 struct GmOsSlobRuntimeNormalSized : public pagePolicyType {
@@ -291,6 +518,11 @@ struct GmOsSlobRuntimeNormalSized : public pagePolicyType {
 	typedef typename slobInfo::addressType addressType;
 	typedef typename slobInfo::objectNumberType objectNumberType;
 	
+	// Pick the next frame type with the object size.
+	addressType nextPageType(addressType slobHeaderSize) const noexcept {
+		return pagePolicyType::nextPageType(slobHeaderSize, objectSize);
+	}
+	
 	// Perform calculation based on every objects' size.
 	addressType numObjects(addressType slobHeaderSize, addressType frameType) const noexcept {
 		addressType pageSize = (1 << slobInfo::pageSizeShift) << pagePolicyType::pageOrderOf(frameType);
@@ -320,6 +552,11 @@ struct GmOsSlobRuntimePow2Sized : public pagePolicyType {
 	typedef typename slobInfo::addressType addressType;
 	typedef typename slobInfo::objectNumberType objectNumberType;
 	
+	// Pick the next frame type with the object size.
+	addressType nextPageType(addressType slobHeaderSize) const noexcept {
+		return pagePolicyType::nextPageType(slobHeaderSize, ((addressType)1) << objectShift);
+	}
+	
 	// Perform calculation based on every objects' size.
 	addressType numObjects(addressType slobHeaderSize, addressType frameType) const noexcept {
 		addressType pageSize = (1 << slobInfo::pageSizeShift) << pagePolicyType::pageOrderOf(frameType);
@@ -335,4 +572,41 @@ struct GmOsSlobRuntimePow2Sized : public pagePolicyType {
 		return (reinterpret_cast<addressType>(objectPointer) - 
 			reinterpret_cast<addressType>(slobPointer)) >> objectShift;
 	}
+};
+
+/// @brief the runtime info where objects' size is known at compile time. Calculation will
+/// be faster as the dividing by constant could be optimized, and no runtime data is stored.
+template<typename slobInfo, unsigned int objectSizeValue, typename pagePolicyType>
+struct GmOsSlobRuntimeStaticSized : public pagePolicyType {
+	// Forward type definitions.
+	typedef typename slobInfo::orderType orderType;
+	typedef typename slobInfo::addressType addressType;
+	typedef typename slobInfo::objectNumberType objectNumberType;
+	
+	/// @brief The object size, which must be aligned, otherwise unexpected problem will 
+	/// occur while accessing words.
+	static constexpr addressType objectSize = objectSizeValue;
+	static_assert(objectSize >= sizeof(objectNumberType), 
+		"The object could not hold the free list of slob.");
+	
+	// Pick the next frame type with the object size.
+	addressType nextPageType(addressType slobHeaderSize) const noexcept {
+		return pagePolicyType::nextPageType(slobHeaderSize, objectSize);
+	}
+	
+	// Perform calculation based on every objects' size.
+	addressType numObjects(addressType slobHeaderSize, addressType frameType) const noexcept {
+		addressType pageSize = (1 << slobInfo::pageSizeShift) << pagePolicyType::pageOrderOf(frameType);
+		return (pageSize - slobHeaderSize) / objectSize;
+	}
+	
+	void* offsetForObject(void* slobPointer, objectNumberType objectNumber) const noexcept {
+		return reinterpret_cast<void*>(reinterpret_cast<addressType>(slobPointer) 
+				+ (objectNumber * objectSize));
+	}
+	
+	objectNumberType offsetFromObject(void* slobPointer, void* objectPointer) const noexcept {
+		return (reinterpret_cast<addressType>(objectPointer) - 
+			reinterpret_cast<addressType>(slobPointer)) / objectSize;
+	}
 };
\ No newline at end of file
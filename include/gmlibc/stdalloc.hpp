@@ -0,0 +1,71 @@
+#pragma once
+/**
+ * @file gmlibc/stdalloc.hpp
+ * @brief Standard Library Allocator Adapter
+ * @author Haoran Luo
+ *
+ * This adapter fulfills the allocator requirement of the standard library, so
+ * that the containers could allocate from the allocators in this library. The
+ * allocation is forwarded to a backend, which decides where the memory comes.
+ *
+ * Please notice the library is built without exceptions, so the failed
+ * allocation returns null pointer instead of throwing std::bad_alloc. The
+ * containers should be used only when the memory is known to be sufficient.
+ */
+
+/**
+ * The concept of an allocator backend. The backend is copied into every rebound
+ * allocator, so it should be as light as a pointer.
+ *
+ * concept backendType {
+ *     // Allocate the memory of (size) bytes with the alignment.
+ *     void* allocate(sizeType size, sizeType alignment) noexcept;
+ *
+ *     // Deallocate the memory of (size) bytes.
+ *     void deallocate(void* memory, sizeType size) noexcept;
+ *
+ *     // Whether the memory allocated from one could be deallocated to another.
+ *     bool operator==(const backendType&) const noexcept;
+ * };
+ */
+
+template<typename T, typename backendType>
+struct GmOsStdAllocator {
+	/// The type definitions required by the standard library.
+	typedef T value_type;
+	typedef decltype(sizeof(T)) size_type;
+
+	/// The backend that the allocation will be forwarded to.
+	backendType backend;
+
+	/// Constructors of the allocator, including the rebinding one.
+	GmOsStdAllocator() noexcept: backend() {}
+	GmOsStdAllocator(const backendType& backend) noexcept: backend(backend) {}
+	template<typename U> GmOsStdAllocator(const GmOsStdAllocator<U, backendType>& other)
+		noexcept: backend(other.backend) {}
+
+	/// Allocate the memory of (count) objects, or null if the allocation fails.
+	T* allocate(size_type count) noexcept {
+		if(count > ((size_type)(-1)) / sizeof(T)) return nullptr;
+		return static_cast<T*>(backend.allocate(count * sizeof(T), alignof(T)));
+	}
+
+	/// Deallocate the memory of (count) objects.
+	void deallocate(T* memory, size_type count) noexcept {
+		if(memory == nullptr) return;
+		backend.deallocate(memory, count * sizeof(T));
+	}
+};
+
+/// The allocators are equal when their backends are equal.
+template<typename T, typename U, typename backendType>
+inline bool operator==(const GmOsStdAllocator<T, backendType>& a,
+	const GmOsStdAllocator<U, backendType>& b) noexcept {
+	return a.backend == b.backend;
+}
+
+template<typename T, typename U, typename backendType>
+inline bool operator!=(const GmOsStdAllocator<T, backendType>& a,
+	const GmOsStdAllocator<U, backendType>& b) noexcept {
+	return !(a.backend == b.backend);
+}
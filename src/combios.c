@@ -7,15 +7,13 @@
  * and documentation details.
  */
 #include "combios.h"
-#define __val(mac) #mac
-#define __tostring(mac) __val(mac)
-#define __swi(mac) "swi " __tostring(mac) ";"
 
 #ifdef __bios_arm_svcid_cpufastset
 
 // Implementation for BIOS function cpuFastSet.
-asm (	"__bios_arm_cpufastset:"
-		__swi(__bios_arm_svcid_cpufastset)
+asm (	".global __bios_arm_cpufastset;"
+		"__bios_arm_cpufastset:"
+		__bios_swi(__bios_arm_svcid_cpufastset)
 		"bx	lr");
 
 // Implementation for function cpufastfill.
@@ -46,3 +44,21 @@ void __bios_arm_cpufastcopy(
 		destinationAddress, numWords);
 }
 #endif
+
+#ifdef __bios_arm_svcid_intrwait
+
+// Implementation for BIOS function intrWait.
+asm (	".global __bios_arm_intrwait;"
+		"__bios_arm_intrwait:"
+		__bios_swi(__bios_arm_svcid_intrwait)
+		"bx	lr");
+#endif
+
+#ifdef __bios_arm_svcid_vblankintrwait
+
+// Implementation for BIOS function vblankIntrWait.
+asm (	".global __bios_arm_vblankintrwait;"
+		"__bios_arm_vblankintrwait:"
+		__bios_swi(__bios_arm_svcid_vblankintrwait)
+		"bx	lr");
+#endif
@@ -0,0 +1,128 @@
+/**
+ * gbadma.c - DMA job queue for GBA.
+ * @author Haoran Luo
+ *
+ * Implementation for the DMA job queue defined in gba/dma.h.
+ * See the header file for usage and documentation details.
+ *
+ * The jobs are kept in a ring buffer. The job at the head of
+ * the ring is programmed into DMA3 with interrupt enabled,
+ * and the completion interrupt retires it and programs the
+ * next job. So the queue keeps going without the caller.
+ */
+#include "gba/dma.h"
+#include "gba/interrupt.h"
+#include "gba/bios.h"
+
+// The DMA channel that the job queue runs on.
+#define __gba_dma_queuechannel 3
+
+// The recorded DMA job, which will be written to the channel.
+typedef struct {
+	const void* source;
+	volatile void* destination;
+	unsigned short count;
+	unsigned short control;
+} __gba_dma_job_t;
+
+// The ring buffer of jobs, and the counter of submitted and retired
+// jobs. The ticket of a job is the submitted counter after submission,
+// which skips zero on wrapping, so that zero remains invalid ticket.
+static __gba_dma_job_t __gba_dma_jobs[__gba_dma_maxjobs];
+static volatile __gba_dma_ticket_t __gba_dma_submitted = 0;
+static volatile __gba_dma_ticket_t __gba_dma_retired = 0;
+
+// Whether the queue has been attached to the dispatcher.
+static int __gba_dma_initialized = 0;
+
+// The ticket following the given one, skipping the zero.
+static __gba_dma_ticket_t __gba_dma_next(__gba_dma_ticket_t ticket) {
+	++ ticket;
+	return ticket != 0? ticket : 1;
+}
+
+// Program the job of ticket into the queue channel.
+static void __gba_dma_start(__gba_dma_ticket_t ticket) {
+	__gba_dma_job_t* job = &__gba_dma_jobs[(ticket - 1) % __gba_dma_maxjobs];
+	volatile __gba_dma_channel_t* channel = &__gba_dma[__gba_dma_queuechannel];
+	channel -> source = job -> source;
+	channel -> destination = (void*)job -> destination;
+	channel -> count = job -> count;
+	channel -> control.halfword = job -> control;
+}
+
+// Retire the finished job and start the next one, under interrupt context.
+static void __gba_dma_service(unsigned short raised) {
+	(void) raised;
+	if(__gba_dma_retired == __gba_dma_submitted) return;
+	__gba_dma_ticket_t retired = __gba_dma_next(__gba_dma_retired);
+	__gba_dma_retired = retired;
+	if(retired != __gba_dma_submitted) __gba_dma_start(__gba_dma_next(retired));
+}
+
+// The service node attached to the dispatcher.
+static __gba_interrupt_service_t __gba_dma_interrupt = {
+	im_dma3, __gba_dma_service, 0
+};
+
+// Implementation for initializing the job queue.
+void __gba_dma_init() {
+	if(__gba_dma_initialized) return;
+	__gba_interrupt_attach(&__gba_dma_interrupt);
+	__gba_dma_initialized = 1;
+}
+
+// Implementation for submitting job.
+__gba_dma_ticket_t __gba_dma_submit(const void* source,
+	volatile void* destination, unsigned int units,
+	int flags, int timing) {
+
+	if(!__gba_dma_initialized) return 0;
+	if(units == 0 || units > 0x10000) return 0;
+	if(timing < dmatime_immediate || timing > dmatime_hblank) return 0;
+
+	// Build up the control register, the count of 0x10000 is written as 0.
+	__gba_dma_control_t control;
+	control.halfword = flags & (dmaflg_dstfixed | dmaflg_fill);
+	control.bits.word = (flags & dmaflg_halfword)? 0 : 1;
+	control.bits.timing = timing;
+	control.bits.irq_enabled = 1;
+	control.bits.enabled = 1;
+
+	// The queue should not be visited by the service while modifying.
+	int master = __gba_interrupt_master;
+	__gba_interrupt_master = 0;
+
+	// Ensure there's still room for the job. The skipped zero is counted
+	// as a job while wrapping, which wastes a slot for the moment.
+	__gba_dma_ticket_t ticket = __gba_dma_next(__gba_dma_submitted);
+	if(ticket - __gba_dma_retired > __gba_dma_maxjobs) {
+		__gba_interrupt_master = master;
+		return 0;
+	}
+
+	// Record the job, and start it if the queue is idle.
+	__gba_dma_job_t* job = &__gba_dma_jobs[(ticket - 1) % __gba_dma_maxjobs];
+	job -> source = source;
+	job -> destination = destination;
+	job -> count = (unsigned short)units;
+	job -> control = control.halfword;
+	__gba_dma_submitted = ticket;
+	if(ticket == __gba_dma_next(__gba_dma_retired)) __gba_dma_start(ticket);
+
+	__gba_interrupt_master = master;
+	return ticket;
+}
+
+// Implementation for checking job status.
+int __gba_dma_done(__gba_dma_ticket_t ticket) {
+	return (int)(__gba_dma_retired - ticket) >= 0;
+}
+
+// Implementation for waiting job.
+void __gba_dma_wait(__gba_dma_ticket_t ticket) {
+	// The DMA3 bit will be set by the dispatcher if the job finishes
+	// before IntrWait, which is then returned immediately.
+	while(!__gba_dma_done(ticket))
+		__bios_intrwait(0, im_dma3);
+}
@@ -0,0 +1,227 @@
+/**
+ * gbafiber.c - Cooperative fibers for GBA.
+ * @author Haoran Luo
+ *
+ * Implementation for the fiber runtime defined in
+ * gba/fiber.h. See the header file for usage and
+ * documentation details.
+ *
+ * The scheduler runs in the main context, and every fiber
+ * switches back to it when suspended, so the scheduler is
+ * the only one who modifies the ready queue. The waiting
+ * fibers are linked in a list, which is walked by the
+ * interrupt service to clear their waited mask, and the
+ * scheduler moves the woken ones to the ready queue.
+ */
+#include "gba/fiber.h"
+#include "gba/interrupt.h"
+#include "gba/video.h"
+#include "gba/mm.h"
+#include "gba/bios.h"
+
+// The saved context is r4 - r11, sp and lr (see gbaswitch.S).
+#define __gba_fiber_contextsize 10
+#define __gba_fiber_contextentry 0
+#define __gba_fiber_contextargument 1
+#define __gba_fiber_contextsp 8
+#define __gba_fiber_contextlr 9
+
+// The range of the stack size shifts.
+#define __gba_fiber_minshift 8
+#define __gba_fiber_maxshift 10
+
+/// The state of a fiber.
+enum __gba_fiber_state {
+	fibst_ready,
+	fibst_running,
+	fibst_waiting,
+	fibst_ended
+};
+
+/// The fiber descriptor, placed at the bottom of the stack.
+struct __gba_fiber {
+	unsigned int context[__gba_fiber_contextsize];
+
+	// The interrupts waited by the fiber, cleared once woken.
+	volatile unsigned short waiting;
+	unsigned char state;
+
+	// The next fiber in the ready queue or the waiting list.
+	struct __gba_fiber* next;
+};
+
+// The context switch routines, which are in the internal wram.
+void __gba_fiber_switch(unsigned int* save,
+	const unsigned int* load) __attribute__((long_call));
+void __gba_fiber_trampoline();
+
+// The allocator of the stacks.
+static __gba_slob_allocator_t __gba_fiber_stacks;
+static unsigned int __gba_fiber_stacksize = 0;
+
+// The state of the scheduler.
+static unsigned int __gba_fiber_main[__gba_fiber_contextsize];
+static __gba_fiber_t* __gba_fiber_current = 0;
+static __gba_fiber_t* __gba_fiber_readyhead = 0;
+static __gba_fiber_t** __gba_fiber_readytail = &__gba_fiber_readyhead;
+static __gba_fiber_t* __gba_fiber_waiters = 0;
+static unsigned int __gba_fiber_count = 0;
+
+// Wake the waiting fibers, under interrupt context.
+static void __gba_fiber_service(unsigned short raised) {
+	__gba_fiber_t* fiber = __gba_fiber_waiters;
+	for(; fiber != 0; fiber = fiber -> next)
+		if((fiber -> waiting & raised) != 0) fiber -> waiting = 0;
+}
+
+// The service node attached to the dispatcher, whose mask is the
+// union of interrupts ever waited.
+static __gba_interrupt_service_t __gba_fiber_interrupt = {
+	0, __gba_fiber_service, 0
+};
+
+// Append the fiber to the ready queue.
+static void __gba_fiber_ready(__gba_fiber_t* fiber) {
+	fiber -> state = fibst_ready;
+	fiber -> next = 0;
+	*__gba_fiber_readytail = fiber;
+	__gba_fiber_readytail = &(fiber -> next);
+}
+
+// Move the woken fibers from the waiting list to the ready queue.
+static void __gba_fiber_wake() {
+	int master = __gba_interrupt_master;
+	__gba_interrupt_master = 0;
+
+	__gba_fiber_t** node = &__gba_fiber_waiters;
+	while(*node != 0) {
+		__gba_fiber_t* fiber = *node;
+		if(fiber -> waiting == 0) {
+			*node = fiber -> next;
+			__gba_fiber_ready(fiber);
+		}
+		else node = &(fiber -> next);
+	}
+
+	__gba_interrupt_master = master;
+}
+
+// Switch from the running fiber back to the scheduler.
+static void __gba_fiber_suspend(unsigned char state) {
+	__gba_fiber_t* fiber = __gba_fiber_current;
+	fiber -> state = state;
+	__gba_fiber_switch(fiber -> context, __gba_fiber_main);
+}
+
+// Implementation for initializing the fiber runtime.
+int __gba_fiber_init(unsigned int stackShift) {
+	if(__gba_fiber_count > 0) return 0;
+	if(stackShift < __gba_fiber_minshift) return 0;
+	if(stackShift > __gba_fiber_maxshift) return 0;
+	if(!__gba_slobinitpw2(&__gba_fiber_stacks, stackShift)) return 0;
+	__gba_fiber_stacksize = 1 << stackShift;
+	return 1;
+}
+
+// Implementation for creating fiber.
+__gba_fiber_t* __gba_fiber_create(__gba_fiber_entry_t entry, void* argument) {
+	if(__gba_fiber_stacksize == 0 || entry == 0) return 0;
+	char* stack = (char*)__gba_sloballoc(&__gba_fiber_stacks);
+	if(stack == 0) return 0;
+
+	// The fiber starts from the trampoline, with the stack pointer
+	// placed at the top of the stack and aligned to 8 bytes.
+	__gba_fiber_t* fiber = (__gba_fiber_t*)stack;
+	unsigned int top = (unsigned int)(stack + __gba_fiber_stacksize);
+	fiber -> context[__gba_fiber_contextentry] = (unsigned int)entry;
+	fiber -> context[__gba_fiber_contextargument] = (unsigned int)argument;
+	fiber -> context[__gba_fiber_contextsp] = top & ~7u;
+	fiber -> context[__gba_fiber_contextlr] = (unsigned int)__gba_fiber_trampoline;
+	fiber -> waiting = 0;
+
+	__gba_fiber_ready(fiber);
+	++ __gba_fiber_count;
+	return fiber;
+}
+
+// Invoked by the trampoline when the entry returns, which will never
+// return as the ended fiber will not be scheduled again.
+void __gba_fiber_exit() {
+	__gba_fiber_suspend(fibst_ended);
+}
+
+// Implementation for running the scheduler.
+void __gba_fiber_run() {
+	if(__gba_fiber_current != 0) return;
+
+	while(__gba_fiber_count > 0) {
+		__gba_fiber_wake();
+
+		// Halt until some interrupt is raised while no fiber is ready.
+		// The raised interrupts are not discarded, so that a fiber woken
+		// after the previous checking will not be missed.
+		__gba_fiber_t* fiber = __gba_fiber_readyhead;
+		if(fiber == 0) {
+			__bios_intrwait(0, __gba_fiber_interrupt.mask);
+			continue;
+		}
+
+		// Remove the fiber from the ready queue and run it.
+		__gba_fiber_readyhead = fiber -> next;
+		if(fiber -> next == 0) __gba_fiber_readytail = &__gba_fiber_readyhead;
+		fiber -> next = 0;
+
+		fiber -> state = fibst_running;
+		__gba_fiber_current = fiber;
+		__gba_fiber_switch(__gba_fiber_main, fiber -> context);
+		__gba_fiber_current = 0;
+
+		// Requeue or release the fiber, the waiting fiber has been
+		// linked to the waiting list by itself.
+		if(fiber -> state == fibst_ready) __gba_fiber_ready(fiber);
+		else if(fiber -> state == fibst_ended) {
+			__gba_slobfree(&__gba_fiber_stacks, fiber);
+			-- __gba_fiber_count;
+		}
+	}
+}
+
+// Implementation for retrieving the running fiber.
+__gba_fiber_t* __gba_fiber_self() {
+	return __gba_fiber_current;
+}
+
+// Implementation for yielding the running fiber.
+void __gba_fiber_yield() {
+	if(__gba_fiber_current == 0) return;
+	__gba_fiber_suspend(fibst_ready);
+}
+
+// Implementation for waiting for interrupts.
+void __gba_fiber_wait_irq(unsigned short mask) {
+	__gba_fiber_t* fiber = __gba_fiber_current;
+	if(fiber == 0 || mask == 0) return;
+
+	// The fiber should be linked before the interrupts are raised, so
+	// that the interrupts raised before switching will not be missed.
+	int master = __gba_interrupt_master;
+	__gba_interrupt_master = 0;
+
+	if((__gba_fiber_interrupt.mask & mask) != mask) {
+		__gba_fiber_interrupt.mask |= mask;
+		__gba_interrupt_attach(&__gba_fiber_interrupt);
+	}
+
+	fiber -> waiting = mask;
+	fiber -> next = __gba_fiber_waiters;
+	__gba_fiber_waiters = fiber;
+
+	__gba_interrupt_master = master;
+	__gba_fiber_suspend(fibst_waiting);
+}
+
+// Implementation for waiting for VBlank.
+void __gba_fiber_wait_vblank() {
+	__gba_video_status.bits.vblank_irq_enabled = 1;
+	__gba_fiber_wait_irq(im_vblank);
+}
@@ -0,0 +1,138 @@
+/**
+ * gbahdma.c - HBlank DMA scanline tables for GBA.
+ * @author Haoran Luo
+ *
+ * Implementation for the scanline tables defined in
+ * gba/dma.h. See the header file for usage and
+ * documentation details.
+ *
+ * The DMA0 is run in HBlank repeat mode with destination
+ * reloaded, so the registers are written once for each
+ * scanline without CPU intervention. The VBlank service
+ * swaps the committed table in and restarts the DMA.
+ */
+#include "gba/dma.h"
+#include "gba/interrupt.h"
+#include "gba/video.h"
+
+// The DMA channel that the scanline tables are streamed on.
+#define __gba_hdma_channel 0
+
+// The state of the scanline tables.
+static volatile void* __gba_hdma_destination = 0;
+static const void* __gba_hdma_tables[2];
+static unsigned short __gba_hdma_units = 0;
+static unsigned short __gba_hdma_control = 0;
+static volatile unsigned char __gba_hdma_front = 0;
+static volatile unsigned char __gba_hdma_pending = 0;
+
+// Restart the DMA from the first scanline of the front table. The
+// DMA will not be triggered during VBlank, so the first scanline is
+// written here, and the DMA will write the next one on each HBlank.
+static void __gba_hdma_restart() {
+	volatile __gba_dma_channel_t* channel = &__gba_dma[__gba_hdma_channel];
+	channel -> control.halfword = 0;
+
+	// Swap the committed table in.
+	if(__gba_hdma_pending) {
+		__gba_hdma_front ^= 1;
+		__gba_hdma_pending = 0;
+	}
+
+	// Write the first scanline with the CPU.
+	const void* table = __gba_hdma_tables[__gba_hdma_front];
+	__gba_dma_control_t control;
+	control.halfword = __gba_hdma_control;
+	unsigned int i, rowSize;
+	if(control.bits.word) {
+		const unsigned int* row = (const unsigned int*)table;
+		volatile unsigned int* destination = (volatile unsigned int*)__gba_hdma_destination;
+		for(i = 0; i < __gba_hdma_units; ++ i) destination[i] = row[i];
+		rowSize = __gba_hdma_units << 2;
+	}
+	else {
+		const unsigned short* row = (const unsigned short*)table;
+		volatile unsigned short* destination = (volatile unsigned short*)__gba_hdma_destination;
+		for(i = 0; i < __gba_hdma_units; ++ i) destination[i] = row[i];
+		rowSize = __gba_hdma_units << 1;
+	}
+
+	// Let the DMA stream the remained scanlines.
+	channel -> source = (const char*)table + rowSize;
+	channel -> destination = (void*)__gba_hdma_destination;
+	channel -> count = __gba_hdma_units;
+	channel -> control.halfword = __gba_hdma_control;
+}
+
+// Restart the scanline tables on VBlank, under interrupt context.
+static void __gba_hdma_service(unsigned short raised) {
+	(void) raised;
+	if(__gba_hdma_destination != 0) __gba_hdma_restart();
+}
+
+// The service node attached to the dispatcher.
+static __gba_interrupt_service_t __gba_hdma_interrupt = {
+	im_vblank, __gba_hdma_service, 0
+};
+
+// Implementation for starting the scanline tables.
+int __gba_hdma_start(volatile void* destination,
+	const void* front, void* back, unsigned int units, int flags) {
+
+	if(destination == 0 || front == 0 || back == 0) return 0;
+	if(units == 0 || units > 0x4000) return 0;
+
+	// Build up the control register, with destination reloaded.
+	__gba_dma_control_t control;
+	control.halfword = 0;
+	control.bits.destination_adjust = dmaadj_reload;
+	control.bits.source_adjust = dmaadj_increment;
+	control.bits.repeat = 1;
+	control.bits.word = (flags & dmaflg_halfword)? 0 : 1;
+	control.bits.timing = dmatime_hblank;
+	control.bits.enabled = 1;
+
+	// The state should not be visited by the service while modifying.
+	int master = __gba_interrupt_master;
+	__gba_interrupt_master = 0;
+
+	__gba_dma[__gba_hdma_channel].control.halfword = 0;
+	__gba_hdma_destination = destination;
+	__gba_hdma_tables[0] = front;
+	__gba_hdma_tables[1] = back;
+	__gba_hdma_units = units;
+	__gba_hdma_control = control.halfword;
+	__gba_hdma_front = 0;
+	__gba_hdma_pending = 0;
+
+	// Restart the tables on each VBlank.
+	__gba_video_status.bits.vblank_irq_enabled = 1;
+	__gba_interrupt_attach(&__gba_hdma_interrupt);
+
+	__gba_interrupt_master = master;
+	return 1;
+}
+
+// Implementation for stopping the scanline tables.
+void __gba_hdma_stop() {
+	int master = __gba_interrupt_master;
+	__gba_interrupt_master = 0;
+
+	__gba_dma[__gba_hdma_channel].control.halfword = 0;
+	__gba_interrupt_detach(&__gba_hdma_interrupt);
+	__gba_hdma_destination = 0;
+
+	__gba_interrupt_master = master;
+}
+
+// Implementation for retrieving the back table.
+void* __gba_hdma_back() {
+	if(__gba_hdma_destination == 0 || __gba_hdma_pending) return 0;
+	return (void*)__gba_hdma_tables[__gba_hdma_front ^ 1];
+}
+
+// Implementation for committing the back table.
+void __gba_hdma_commit() {
+	if(__gba_hdma_destination == 0) return;
+	__gba_hdma_pending = 1;
+}
@@ -0,0 +1,74 @@
+/**
+ * gbaintr.c - Interrupt dispatcher for GBA.
+ * @author Haoran Luo
+ *
+ * Implementation for the interrupt dispatcher defined in
+ * gba/interrupt.h. See the header file for usage and
+ * documentation details.
+ *
+ * This file should be compiled in ARM mode, as the BIOS
+ * will enter the interrupt handler under ARM mode.
+ */
+#include "gba/interrupt.h"
+
+// The attached services, in the order of attachment.
+static __gba_interrupt_service_t* __gba_interrupt_services
+	__attribute__((section(".iwram.data"))) = 0;
+
+// Implementation for the interrupt dispatcher. Placed in the internal
+// wram so that the interrupt latency is minimal.
+__attribute__((section(".iwram.text")))
+void __gba_interrupt_dispatch() {
+	unsigned short raised = __gba_interrupt_flag.halfword
+		& __gba_interrupt_enabled.halfword;
+
+	// Acknowledge the interrupts by writing their bits back, and
+	// notify the BIOS IntrWait function.
+	__gba_interrupt_flag.halfword = raised;
+	__gba_interrupt_check.halfword |= raised;
+
+	// Notify the services interested in the raised interrupts.
+	__gba_interrupt_service_t* service = __gba_interrupt_services;
+	for(; service != 0; service = service -> next)
+		if((service -> mask & raised) != 0)
+			service -> service(service -> mask & raised);
+}
+
+// Implementation for attaching interrupt service.
+void __gba_interrupt_attach(__gba_interrupt_service_t* service) {
+	if(service == 0) return;
+
+	// The service list should not be visited while modifying.
+	int master = __gba_interrupt_master;
+	__gba_interrupt_master = 0;
+
+	// Append the service to the end of the list.
+	__gba_interrupt_service_t** tail = &__gba_interrupt_services;
+	while(*tail != 0 && *tail != service) tail = &((*tail) -> next);
+	if(*tail == 0) {
+		service -> next = 0;
+		*tail = service;
+	}
+
+	// Install the dispatcher and enable the interrupts.
+	__gba_interrupt_handler = __gba_interrupt_dispatch;
+	__gba_interrupt_enabled.halfword |= service -> mask;
+	__gba_interrupt_master = master;
+}
+
+// Implementation for detaching interrupt service.
+void __gba_interrupt_detach(__gba_interrupt_service_t* service) {
+	if(service == 0) return;
+
+	// The service list should not be visited while modifying.
+	int master = __gba_interrupt_master;
+	__gba_interrupt_master = 0;
+
+	// Remove the service from the list.
+	__gba_interrupt_service_t** node = &__gba_interrupt_services;
+	while(*node != 0 && *node != service) node = &((*node) -> next);
+	if(*node != 0) *node = service -> next;
+	service -> next = 0;
+
+	__gba_interrupt_master = master;
+}
@@ -8,16 +8,24 @@
  */
 #define __gba_mmqualifier __attribute__((weak))
 #include "gba/mm.h"
+#include "gba/memory.h"
+#include "gba/interrupt.h"
 #include "gmlibc/buddy.hpp"
 #include "gmlibc/dlmalloc.hpp"
 #include "gmlibc/slob.hpp"
+#include "gmlibc/arena.hpp"
 #include <new>
 #define TRUE  1
 #define FALSE 0
 
-/// @brief Forward the definition of external working RAM's size.
+/// @brief Forward the definition of external working RAM's size, which is the 
+/// count of words uploaded to the external working RAM.
 extern "C" int __gba_ewram_size;
 
+/// @brief Forward the definition of internal working RAM's size, which is the 
+/// count of words uploaded to the internal working RAM.
+extern "C" int __gba_iwram_size;
+
 /// @brief The generic type information to be used with working RAM.
 struct __gba_ewram_info {
 	// Buddy allocator part.
@@ -27,16 +35,6 @@ struct __gba_ewram_info {
 	/// Maximum page order allowed to allocate.
 	static constexpr orderType maxPageOrder = 6;
 	
-	/// The page frame number's type definition.
-	typedef unsigned char pfnType;
-	
-	/// How many bytes does should the bitmap in the buddy system 
-	/// allocator occupies.
-	static constexpr orderType bitmapTotalSize = 32;
-	
-	/// The offsets of bitmap for each page order.
-	static const pfnType bitmapOrderOffset[maxPageOrder];
-	
 	/// The shift for a page. Defaultly set to 2048 (1 << 11) bytes.
 	static constexpr orderType pageSizeShift = 11;
 	
@@ -46,14 +44,18 @@ struct __gba_ewram_info {
 	static_assert(sizeof(void*) == sizeof(int), "Unexpected building "
 		"architecture, please validate your building parameters!");
 	
+	/// The size of the external working RAM, where the page frame number's type
+	/// and the bitmap of the buddy system allocator are derived from.
+	static constexpr addressType regionSize = 0x40000;
+	
 	/// Retrieve the size of area in the working memory region.
-	static pfnType initialPageFrame() noexcept {
-		return (__gba_ewram_size + (1 << pageSizeShift) - 1) >> pageSizeShift;
+	static addressType initialPageFrame() noexcept {
+		return ((__gba_ewram_size << 2) + (1 << pageSizeShift) - 1) >> pageSizeShift;
 	}
 	
 	/// Total number of page frames in working memory.
-	static pfnType totalPageFrame() noexcept {
-			return 128 - initialPageFrame();
+	static addressType totalPageFrame() noexcept {
+			return (regionSize >> pageSizeShift) - initialPageFrame();
 	}
 	
 	/// The first available page frame for dynamic page allocation.
@@ -66,7 +68,23 @@ struct __gba_ewram_info {
 	static constexpr addressType nullPageAddress = 0;
     
 	/// Shrink page whenever it is possible. (For high page break using buddy).
+	/// At most two free blocks are shrunk per deallocation, and the rest are 
+	/// left for trimming.
 	static constexpr bool deftHighBreakShrink = true;
+	static constexpr orderType highBreakShrinkSteps = 2;
+	
+	/// Cache the recently freed pages of order 0 and 1, where the slob frames and
+	/// the page chunks churn.
+	static constexpr orderType hotPageOrders = 2;
+	static constexpr orderType hotPageDepth = 4;
+	
+	/// Record the peak usage of the allocators only if the statistics are 
+	/// queried, so that the release builds pay nothing.
+#ifdef __gba_mmstat
+	static constexpr bool collectStatistics = true;
+#else
+	static constexpr bool collectStatistics = false;
+#endif
 	
 	// Fine allocator part.
 	/// Forward the definition of dynamic allocate size type.
@@ -75,13 +93,15 @@ struct __gba_ewram_info {
 	/// The definition of each chunk size type.
 	typedef unsigned short chunkSizeType;
 	
-	/// The 8 - 63 byte's allocation request will be passed into fast bin
-	/// request.
-	static constexpr orderType fastbinMaxOrder = 6;
+	/// Grow the top chunk with a page more, and trim it only if more than 2 
+	/// free pages lie on it, so that the allocations and deallocations near
+	/// the top chunk will not move the low break point back and forth.
+	static constexpr orderType topPadPages = 1;
+	static constexpr orderType trimThresholdPages = 2;
 	
-	/// The 64 - 511 byte's allocation request will be passed into small
+	/// The 8 - 511 byte's allocation request will be passed into small
 	/// bin's allocation request. And the 512 - 2039's allocation request
-	/// will be passed to large bin's request.
+	/// will be passed to the best fit search of the tree bins.
 	static constexpr orderType smallbinMaxOrder = 9;
 	
 	/// Returned when fails to allocate chunk.
@@ -89,18 +109,13 @@ struct __gba_ewram_info {
 	
 	// The memory clearing part.
 	static void memzero(char* memory, __gba_size_t size) noexcept {
-		// @XXX This function is just a stub, please complete it with gba 
-		// specific library function.
-		volatile char* vmemory = memory;
-		//__gba_memzero(memory, size);
-		for(__gba_size_t i = 0; i < size; ++ i) vmemory[i] = 0;
+		__gba_memset(memory, 0, size);
 	}
 	
 	// We can safely assume all pointer values are 0 in our application.
 	template<typename pointerType> static void memzptr(pointerType* pointer, 
 		const pointerType& zvalue, __gba_size_t numPointer) noexcept {
 		
-		// __gba_memzero(pointer, numPointer * sizeof(pointerType));
 		memzero((char*)pointer, numPointer * sizeof(pointerType));
 	}
 	
@@ -110,8 +125,6 @@ struct __gba_ewram_info {
 	static constexpr bool deftSlobDeallocate = true;
 };
 
-const unsigned char __gba_ewram_info::bitmapOrderOffset[maxPageOrder] __attribute__((weak)) = {0, 128, 64, 32, 16, 8};
-
 // Forward the allocator definitions.
 typedef GmOsPageAllocatorBuddy<__gba_ewram_info> pageAllocatorType;
 static_assert(sizeof(pageAllocatorType) <= sizeof(__gba_page_allocator_t),
@@ -123,6 +136,7 @@ static_assert(sizeof(fineAllocatorType) <= sizeof(__gba_malloc_allocator_t),
 // The caching pointers.
 pageAllocatorType* pageAllocator __attribute__((section(".iwram.data"), weak)) = nullptr;
 fineAllocatorType* fineAllocator __attribute__((section(".iwram.data"), weak)) = nullptr;
+fineAllocatorType* iwramAllocator __attribute__((section(".iwram.data"), weak)) = nullptr;
 
 // Perform page allocator initialization.
 __gba_bool_t __gba_pageinit(__gba_page_allocator_t* region) {
@@ -151,6 +165,224 @@ void __gba_pagefree(__gba_page_t page, __gba_order_t pageOrder) {
 		pageAllocatorType::pageType>(page), pageOrder);
 }
 
+// Allocate pages for certain order in bulk.
+__gba_size_t __gba_pagealloc_n(__gba_order_t pageOrder, __gba_page_t* pages, __gba_size_t count) {
+	if(!__gba_pagehasinit()) return 0;
+	if(pages == nullptr) return 0;
+	return pageAllocator -> allocateHighPages(pageOrder, count,
+		reinterpret_cast<pageAllocatorType::pageType*>(pages));
+}
+
+// Deallocate pages for certain order in bulk.
+void __gba_pagefree_n(__gba_page_t* pages, __gba_size_t count, __gba_order_t pageOrder) {
+	if(!__gba_pagehasinit()) return;
+	if(pages == nullptr) return;
+	pageAllocator -> freeHighPages(pageOrder, count,
+		reinterpret_cast<pageAllocatorType::pageType*>(pages));
+}
+
+// Return the cached pages back to the page allocator.
+__gba_size_t __gba_pagedrain() {
+	if(!__gba_pagehasinit()) return 0;
+	return pageAllocator -> drainHotPages();
+}
+
+// Shrink the high break point within the budget.
+__gba_size_t __gba_pagetrim(__gba_size_t budget) {
+	if(!__gba_pagehasinit()) return 0;
+	return pageAllocator -> shrinkHighPage(budget);
+}
+
+// Type definitions for page reservation.
+typedef GmOsPageReserve<pageAllocatorType> pageReserveType;
+static_assert(sizeof(pageReserveType) <= sizeof(__gba_page_reserve_t),
+	"The size of page reservation does not fit in with its underlying object.");
+
+// Reserve pages from the page allocator.
+__gba_bool_t __gba_pagereserve(__gba_page_reserve_t* region, 
+	__gba_order_t pageOrder, __gba_size_t count) {
+	if(region == nullptr) return FALSE;
+	if(!__gba_pagehasinit()) return FALSE;
+	if(pageOrder >= __gba_ewram_info::maxPageOrder) return FALSE;
+	pageReserveType* reserve = new ((unsigned char*)region) 
+		pageReserveType(*pageAllocator, pageOrder);
+	return reserve -> reserve(count)? TRUE : FALSE;
+}
+
+// Allocate a page from the reservation.
+__gba_page_t __gba_pagealloc_reserved(__gba_page_reserve_t* region) {
+	if(region == nullptr) return nullptr;
+	return reinterpret_cast<pageReserveType*>(region) -> allocate();
+}
+
+// Deallocate a page back to the reservation.
+void __gba_pagefree_reserved(__gba_page_reserve_t* region, __gba_page_t page) {
+	if(region == nullptr) return;
+	reinterpret_cast<pageReserveType*>(region) -> deallocate(
+		reinterpret_cast<pageAllocatorType::pageType>(page));
+}
+
+// Return the unused reserved pages back to the page allocator.
+__gba_size_t __gba_pagerelease(__gba_page_reserve_t* region) {
+	if(region == nullptr) return 0;
+	return reinterpret_cast<pageReserveType*>(region) -> release();
+}
+
+// Initialize a page allocator over a span from the page allocator.
+__gba_bool_t __gba_pagespaninit(__gba_page_allocator_t* region, __gba_order_t spanOrder) {
+	if(region == nullptr) return FALSE;
+	if(!__gba_pagehasinit()) return FALSE;
+	pageAllocatorType::pageType span = pageAllocator -> allocateHighPage(spanOrder);
+	if(span == (pageAllocatorType::pageType)__gba_ewram_info::nullPageAddress) return FALSE;
+	new ((unsigned char*)region) pageAllocatorType(reinterpret_cast<
+		__gba_ewram_info::addressType>(span), 1 << spanOrder);
+	return TRUE;
+}
+
+// Return the span back to the page allocator.
+void __gba_pagespanfree(__gba_page_allocator_t* region) {
+	if(region == nullptr) return;
+	if(!__gba_pagehasinit()) return;
+	pageAllocatorType* span = reinterpret_cast<pageAllocatorType*>(region);
+	if(span == pageAllocator) return;
+	
+	__gba_order_t spanOrder = 0;
+	for(; (1 << spanOrder) < span -> totalPageFrame(); ++ spanOrder);
+	pageAllocator -> freeHighPage(reinterpret_cast<pageAllocatorType::pageType>(
+		span -> firstPageAddress()), spanOrder);
+}
+
+/// @brief The page policy of the small chunk caches. The frame type is tagged with 
+/// the index of the cache, so that the cache owning a chunk could be found by 
+/// decoding the frame header.
+struct __gba_small_policy {
+	typedef __gba_ewram_info::orderType orderType;
+	typedef __gba_ewram_info::addressType addressType;
+	
+	/// The frame tag of the first cache.
+	static constexpr addressType frameTagBase = 0x5ca1ab00;
+	
+	/// The frame tag of this cache.
+	addressType frameTag;
+	
+	/// Just single page will be accepted, and the page type is the frame tag.
+	addressType nextPageType(addressType) const noexcept { return frameTag; }
+	bool isValidFrameType(addressType frameType) const noexcept { return frameType == frameTag; }
+	static orderType pageOrderOf(addressType) noexcept { return 0; }
+	static addressType magicForType(addressType frameType) noexcept { return 0xcafebabe ^ frameType; }
+	
+	/// Do nothing while allocating more object.
+	static void objectCreated() noexcept {}
+	static void objectDestroyed() noexcept {}
+};
+
+/// @brief The runtime info of the small chunk caches. As the division is done by
+/// software, the number of objects in a frame and the reciprocal of the object 
+/// size are calculated while initializing.
+struct __gba_small_runtime : public __gba_small_policy {
+	typedef __gba_ewram_info::objectNumberType objectNumberType;
+	
+	/// The reciprocal is scaled by (1 << reciprocalShift), which is precise for
+	/// the offsets inside a page.
+	static constexpr int reciprocalShift = 20;
+	
+	/// The object size, the number of objects in a frame and the reciprocal.
+	addressType objectSize, objectCount, objectReciprocal;
+	
+	// Perform calculation based on the precalculated values.
+	addressType numObjects(addressType, addressType) const noexcept {
+		return objectCount;
+	}
+	
+	void* offsetForObject(void* slobPointer, objectNumberType objectNumber) const noexcept {
+		return reinterpret_cast<void*>(reinterpret_cast<addressType>(slobPointer) 
+				+ (objectNumber * objectSize));
+	}
+	
+	objectNumberType offsetFromObject(void* slobPointer, void* objectPointer) const noexcept {
+		unsigned int offset = reinterpret_cast<addressType>(objectPointer) - 
+			reinterpret_cast<addressType>(slobPointer);
+		return (offset * objectReciprocal) >> reciprocalShift;
+	}
+};
+
+// Type definitions for the small chunk caches.
+typedef GmOsFineAllocatorSlob<__gba_ewram_info, pageAllocatorType, __gba_small_runtime> smallAllocatorType;
+typedef smallAllocatorType::GmOsFineChunkSlob smallFrameType;
+static_assert(sizeof(smallAllocatorType) <= sizeof(__gba_slob_allocator_t::data),
+	"The size of small chunk cache does not fit in with its underlying object.");
+
+// The size classes of the small chunk caches, and the size class of each 4 bytes.
+static constexpr int smallCacheCount = 7;
+static constexpr __gba_size_t smallCacheMaxSize = 64;
+static constexpr unsigned char smallCacheSizes[smallCacheCount] = 
+	{ 8, 12, 16, 24, 32, 48, 64 };
+static constexpr unsigned char smallCacheClasses[smallCacheMaxSize >> 2] = 
+	{ 0, 0, 1, 2, 3, 3, 4, 4, 5, 5, 5, 5, 6, 6, 6, 6 };
+
+// The small chunk caches, which are initialized on demand.
+__gba_slob_allocator_t smallCaches[smallCacheCount] __attribute__((weak));
+bool smallCacheInitialized __attribute__((weak)) = false;
+
+// Retrieve the small chunk cache.
+static inline smallAllocatorType* smallCache(int index) {
+	return reinterpret_cast<smallAllocatorType*>(smallCaches[index].data);
+}
+
+// Initialize the runtime info of the small chunk cache.
+static void smallRuntimeOf(__gba_small_runtime& rti, int index) {
+	rti.frameTag = __gba_small_policy::frameTagBase + index;
+	rti.objectSize = smallCacheSizes[index];
+	rti.objectCount = ((1 << __gba_ewram_info::pageSizeShift) 
+		- smallFrameType::slobHeaderSize) / rti.objectSize;
+	rti.objectReciprocal = ((1 << __gba_small_runtime::reciprocalShift) 
+		+ rti.objectSize - 1) / rti.objectSize;
+}
+
+// Initialize the small chunk caches if they're not initialized.
+static bool smallCacheReady() {
+	if(smallCacheInitialized) return true;
+	if(pageAllocator == nullptr) return false;
+	for(int index = 0; index < smallCacheCount; ++ index) {
+		__gba_small_runtime rti; 
+		smallRuntimeOf(rti, index);
+		new ((unsigned char*) smallCaches[index].data) smallAllocatorType(*pageAllocator, rti);
+	}
+	smallCacheInitialized = true;
+	return true;
+}
+
+// Find the small chunk cache of the size class, or -1 if the size is not small.
+static inline int smallCacheFor(__gba_size_t chunkSize) {
+	if(chunkSize > smallCacheMaxSize) return -1;
+	return smallCacheClasses[(chunkSize - 1) >> 2];
+}
+
+// Find the small chunk cache owning the chunk by decoding the frame header of 
+// its page, or -1 if the chunk is not in a small chunk cache. The small chunk 
+// caches only own the high pages, so the chunks below the low break point are 
+// never decoded. Neither are the page chunks of the malloc allocator, which lie
+// inside the frame header if the page were a slob frame.
+static int smallCacheOf(__gba_chunk_t chunk) {
+	if(!smallCacheInitialized) return -1;
+	typedef __gba_ewram_info::addressType addressType;
+	addressType chunkAddress = reinterpret_cast<addressType>(chunk);
+	addressType lowBreak = reinterpret_cast<addressType>(pageAllocator -> lowPageBreak());
+	if(chunkAddress < pageAllocator -> firstPageAddress()) return -1;
+	if(lowBreak != __gba_ewram_info::nullPageAddress && 
+		chunkAddress < lowBreak + (1 << __gba_ewram_info::pageSizeShift)) return -1;
+	addressType frameAddress = chunkAddress 
+		& ~((1 << __gba_ewram_info::pageSizeShift) - 1);
+	if(chunkAddress - frameAddress < smallFrameType::slobHeaderSize) return -1;
+	smallFrameType* frame = reinterpret_cast<smallFrameType*>(frameAddress);
+	
+	// Validate the frame with the cache that the frame type tagged.
+	unsigned int index = frame -> frameType - __gba_small_policy::frameTagBase;
+	if(index >= smallCacheCount) return -1;
+	if(!frame -> isSlobHeader(smallCache(index) -> runtimeInfo())) return -1;
+	return index;
+}
+
 // Perform malloc allocator initialization.
 __gba_bool_t __gba_mallocinit(__gba_malloc_allocator_t* region) {
 	if(fineAllocator != nullptr) return TRUE;
@@ -165,22 +397,111 @@ __gba_bool_t __gba_mallochasinit() {
 	return (fineAllocator != nullptr)? TRUE : FALSE;
 }
 
-// Allocate chunk for certain size.
+// Allocate chunk for certain size. The small chunk caches are consulted first,
+// and the malloc allocator will take over when the cache is exhausted.
 __gba_chunk_t __gba_malloc(__gba_size_t chunkSize) {
 	if(!__gba_mallochasinit()) return nullptr;
 	if(chunkSize <= 0) return nullptr;
+	int index = smallCacheFor(chunkSize);
+	if(index >= 0 && smallCacheReady()) {
+		__gba_chunk_t chunk = smallCache(index) -> allocate();
+		if(chunk != nullptr) return chunk;
+	}
 	return fineAllocator -> allocate(chunkSize);
 }
 
-// Free chunk for certain size.
+// The internal working RAM, where the user stack grows down from the top set 
+// by the BIOS, while the interrupt and supervisor stacks are above.
+static constexpr __gba_ewram_info::addressType iwramBase = 0x03000000;
+static constexpr __gba_ewram_info::addressType iwramStackTop = 0x03007f00;
+
+// Check whether the chunk is allocated from the internal working RAM zone.
+static inline bool iwramOwns(__gba_chunk_t chunk) {
+	return iwramAllocator != nullptr &&
+		(reinterpret_cast<__gba_ewram_info::addressType>(chunk) >> 24) == (iwramBase >> 24);
+}
+
+// Initialize the zone over the unused internal working RAM.
+__gba_bool_t __gba_iwraminit(__gba_page_allocator_t* pageRegion, 
+	__gba_malloc_allocator_t* region, __gba_size_t stackReserve) {
+	typedef __gba_ewram_info::addressType addressType;
+	if(iwramAllocator != nullptr) return TRUE;
+	if(pageRegion == nullptr || region == nullptr) return FALSE;
+	
+	// The zone starts after the uploaded code and data, aligned to double words.
+	addressType zoneBase = (iwramBase + (__gba_iwram_size << 2) + 7) & ~7;
+	if(stackReserve >= (__gba_size_t)(iwramStackTop - zoneBase)) return FALSE;
+	addressType zoneLimit = iwramStackTop - stackReserve;
+	addressType zonePages = (zoneLimit - zoneBase) >> __gba_ewram_info::pageSizeShift;
+	if(zonePages == 0) return FALSE;
+	
+	// Initialize the page allocator and heap of the zone.
+	pageAllocatorType* zonePageAllocator = new ((unsigned char*)pageRegion) 
+		pageAllocatorType(zoneBase, zonePages);
+	new ((unsigned char*) region) fineAllocatorType(*zonePageAllocator);
+	iwramAllocator = reinterpret_cast<fineAllocatorType*>(region);
+	return TRUE;
+}
+
+// Allocate chunk with placement hint, falling back to the malloc allocator.
+__gba_chunk_t __gba_malloc_hint(__gba_size_t chunkSize, int hint) {
+	if(chunkSize <= 0) return nullptr;
+	if((hint & memhint_fast) != 0 && iwramAllocator != nullptr) {
+		__gba_chunk_t chunk = iwramAllocator -> allocate(chunkSize);
+		if(chunk != nullptr) return chunk;
+	}
+	return __gba_malloc(chunkSize);
+}
+
+// Free chunk for certain size. The owner is decided by the address and then the
+// frame header.
 void __gba_free(__gba_chunk_t chunk) {
+	if(chunk == nullptr) return;
+	if(iwramOwns(chunk)) {
+		iwramAllocator -> deallocate(chunk);
+		return;
+	}
 	if(!__gba_mallochasinit()) return;
+	int index = smallCacheOf(chunk);
+	if(index >= 0) smallCache(index) -> deallocate(chunk);
+	else fineAllocator -> deallocate(chunk);
+}
+
+// Trim the top chunk of the malloc allocator.
+__gba_size_t __gba_malloctrim(__gba_size_t padPages) {
+	if(!__gba_mallochasinit()) return 0;
+	
+	// Keeping no fewer pages than the free ones returns nothing, and the pad
+	// is narrowed only after clamping.
+	if(padPages >= fineAllocator -> topChunkFreePages()) return 0;
+	return fineAllocator -> shrinkTopChunk((fineAllocatorType::pfnType)padPages);
+}
+
+// Create a heap over the page allocator.
+__gba_bool_t __gba_heap_create(__gba_page_allocator_t* pageRegion, __gba_malloc_allocator_t* region) {
+	if(pageRegion == nullptr || region == nullptr) return FALSE;
+	pageAllocatorType* heapPageAllocator = reinterpret_cast<pageAllocatorType*>(pageRegion);
+	if(heapPageAllocator == pageAllocator && fineAllocator != nullptr) return FALSE;
+	new ((unsigned char*) region) fineAllocatorType(*heapPageAllocator);
+	return TRUE;
+}
+
+// Allocate chunk from the heap.
+__gba_chunk_t __gba_heap_malloc(__gba_malloc_allocator_t* region, __gba_size_t chunkSize) {
+	if(region == nullptr) return nullptr;
+	if(chunkSize <= 0) return nullptr;
+	return reinterpret_cast<fineAllocatorType*>(region) -> allocate(chunkSize);
+}
+
+// Free chunk to the heap.
+void __gba_heap_free(__gba_malloc_allocator_t* region, __gba_chunk_t chunk) {
+	if(region == nullptr) return;
 	if(chunk == nullptr) return;
-	fineAllocator -> deallocate(chunk);
+	reinterpret_cast<fineAllocatorType*>(region) -> deallocate(chunk);
 }
 
 // Type definitions for slob allocator.
-typedef GmOsSlobPagePolicyNaiveSingle<__gba_ewram_info> pagePolicyType;
+typedef GmOsSlobPagePolicyAdaptive<__gba_ewram_info> pagePolicyType;
 
 static constexpr int slobNormalTypeId = 0;
 typedef GmOsSlobRuntimeNormalSized<__gba_ewram_info, __gba_size_t, pagePolicyType> slobNormalRtiType;
@@ -192,7 +513,7 @@ typedef GmOsFineAllocatorSlob<__gba_ewram_info, pageAllocatorType, slobPow2RtiTy
 
 static constexpr __gba_size_t objectNumberTypeSize = sizeof(slobNormalAllocatorType::objectNumberType);
 static_assert(
-	sizeof(__gba_slob_allocator_t::data) >= sizeof(slobNormalAllocatorType)||
+	sizeof(__gba_slob_allocator_t::data) >= sizeof(slobNormalAllocatorType) &&
 	sizeof(__gba_slob_allocator_t::data) >= sizeof(slobPow2AllocatorType), 
 	"The size of slob allocator does not fit in with its underlying object.");
 
@@ -240,17 +561,382 @@ __gba_chunk_t __gba_sloballoc(__gba_slob_allocator_t* region) {
 }
 
 // Perform slob deallocation based on slob type.
-void __gba_slobfree(__gba_slob_allocator_t* region, __gba_chunk_t memory) {
+__gba_bool_t __gba_slobfree(__gba_slob_allocator_t* region, __gba_chunk_t memory) {
+	if(region == nullptr) return FALSE;
+	switch(region -> type) {
+		case slobNormalTypeId: {
+			return reinterpret_cast<slobNormalAllocatorType*>(region -> data) 
+				-> deallocate(memory)? TRUE : FALSE;
+		} break;
+		
+		case slobPow2TypeId: {
+			return reinterpret_cast<slobPow2AllocatorType*>(region -> data) 
+				-> deallocate(memory)? TRUE : FALSE;
+		} break;
+		
+		default: {
+			return FALSE;
+		} break;
+	}
+}
+
+// Perform slob allocation in bulk based on slob type.
+__gba_size_t __gba_sloballoc_n(__gba_slob_allocator_t* region, 
+	__gba_chunk_t* chunks, __gba_size_t count) {
+	if(region == nullptr) return 0;
+	if(chunks == nullptr) return 0;
+	switch(region -> type) {
+		case slobNormalTypeId: {
+			return reinterpret_cast<slobNormalAllocatorType*>(region -> data) -> allocateBulk(chunks, count);
+		} break;
+		
+		case slobPow2TypeId: {
+			return reinterpret_cast<slobPow2AllocatorType*>(region -> data) -> allocateBulk(chunks, count);
+		} break;
+		
+		default: {
+			return 0;
+		} break;
+	}
+}
+
+// Perform slob deallocation in bulk based on slob type.
+__gba_size_t __gba_slobfree_n(__gba_slob_allocator_t* region, 
+	__gba_chunk_t* chunks, __gba_size_t count) {
+	if(region == nullptr) return 0;
+	if(chunks == nullptr) return 0;
+	switch(region -> type) {
+		case slobNormalTypeId: {
+			return reinterpret_cast<slobNormalAllocatorType*>(region -> data) -> deallocateBulk(chunks, count);
+		} break;
+		
+		case slobPow2TypeId: {
+			return reinterpret_cast<slobPow2AllocatorType*>(region -> data) -> deallocateBulk(chunks, count);
+		} break;
+		
+		default: {
+			return 0;
+		} break;
+	}
+}
+
+// Set the watermarks of retained frames based on slob type.
+void __gba_slobretain(__gba_slob_allocator_t* region, __gba_size_t low, __gba_size_t high) {
 	if(region == nullptr) return;
+	typedef slobNormalAllocatorType::objectNumberType objectNumberType;
+	if(high > (objectNumberType)(-1)) high = (objectNumberType)(-1);
+	if(low > high) low = high;
 	switch(region -> type) {
 		case slobNormalTypeId: {
-			reinterpret_cast<slobNormalAllocatorType*>(region -> data) -> deallocate(memory);
+			reinterpret_cast<slobNormalAllocatorType*>(region -> data) -> setRetention(low, high);
 		} break;
 		
 		case slobPow2TypeId: {
-			reinterpret_cast<slobPow2AllocatorType*>(region -> data) -> deallocate(memory);
+			reinterpret_cast<slobPow2AllocatorType*>(region -> data) -> setRetention(low, high);
 		} break;
 		
 		default: {} break;
 	}
-}
\ No newline at end of file
+}
+
+// Deallocate the retained frames based on slob type.
+__gba_size_t __gba_slobshrink(__gba_slob_allocator_t* region) {
+	if(region == nullptr) return 0;
+	switch(region -> type) {
+		case slobNormalTypeId: {
+			return reinterpret_cast<slobNormalAllocatorType*>(region -> data) -> shrink();
+		} break;
+		
+		case slobPow2TypeId: {
+			return reinterpret_cast<slobPow2AllocatorType*>(region -> data) -> shrink();
+		} break;
+		
+		default: {
+			return 0;
+		} break;
+	}
+}
+
+// Allocate chunk for certain size, which will be specified while deallocating.
+__gba_chunk_t __gba_malloc_sized(__gba_size_t chunkSize) {
+	if(chunkSize <= 0) chunkSize = 1;
+	int index = smallCacheFor(chunkSize);
+	if(index < 0) return __gba_malloc(chunkSize);
+	if(!smallCacheReady()) return nullptr;
+	return smallCache(index) -> allocate();
+}
+
+// Free chunk for certain size, or decode its owner if unknown.
+void __gba_free_sized(__gba_chunk_t chunk, __gba_size_t chunkSize) {
+	if(chunk == nullptr) return;
+	
+	// The chunks above the small chunk cache limit are from the malloc allocator.
+	if(chunkSize > smallCacheMaxSize) {
+		if(__gba_mallochasinit()) fineAllocator -> deallocate(chunk);
+		return;
+	}
+	
+	int index = (chunkSize > 0)? smallCacheFor(chunkSize) : smallCacheOf(chunk);
+	if(index >= 0) smallCache(index) -> deallocate(chunk);
+	else __gba_free(chunk);
+}
+
+// Type definitions for arena allocator.
+typedef GmOsFineAllocatorArena<__gba_ewram_info, pageAllocatorType> arenaAllocatorType;
+static_assert(sizeof(arenaAllocatorType) <= sizeof(__gba_arena_allocator_t),
+	"The size of arena allocator does not fit in with its underlying object.");
+typedef GmOsFineAllocatorArenaPair<arenaAllocatorType> arenaPairType;
+static_assert(sizeof(arenaPairType) <= sizeof(__gba_arena_pair_t),
+	"The size of arena pair does not fit in with its underlying object.");
+
+// Initialize an arena allocator for certain block order.
+__gba_bool_t __gba_arenainit(__gba_arena_allocator_t* region, __gba_order_t blockOrder) {
+	if(region == nullptr) return FALSE;
+	if(pageAllocator == nullptr) return FALSE;
+	if(blockOrder >= __gba_ewram_info::maxPageOrder) return FALSE;
+	new ((unsigned char*) region) arenaAllocatorType(*pageAllocator, blockOrder);
+	return TRUE;
+}
+
+// Allocate object from the arena.
+__gba_chunk_t __gba_arenaalloc(__gba_arena_allocator_t* region, 
+	__gba_size_t chunkSize, __gba_size_t alignment) {
+	if(region == nullptr) return nullptr;
+	return reinterpret_cast<arenaAllocatorType*>(region) -> allocate(chunkSize, alignment);
+}
+
+// Reset the arena.
+void __gba_arenareset(__gba_arena_allocator_t* region) {
+	if(region == nullptr) return;
+	reinterpret_cast<arenaAllocatorType*>(region) -> reset();
+}
+
+// Release the blocks of the arena.
+void __gba_arenarelease(__gba_arena_allocator_t* region) {
+	if(region == nullptr) return;
+	reinterpret_cast<arenaAllocatorType*>(region) -> release();
+}
+
+// Initialize an arena pair for certain block order.
+__gba_bool_t __gba_arenapairinit(__gba_arena_pair_t* region, __gba_order_t blockOrder) {
+	if(region == nullptr) return FALSE;
+	if(pageAllocator == nullptr) return FALSE;
+	if(blockOrder >= __gba_ewram_info::maxPageOrder) return FALSE;
+	new ((unsigned char*) region) arenaPairType(*pageAllocator, blockOrder);
+	return TRUE;
+}
+
+// Allocate object from the front arena of the pair.
+__gba_chunk_t __gba_arenapairalloc(__gba_arena_pair_t* region, 
+	__gba_size_t chunkSize, __gba_size_t alignment) {
+	if(region == nullptr) return nullptr;
+	return reinterpret_cast<arenaPairType*>(region) -> allocate(chunkSize, alignment);
+}
+
+// Flip the arena pair.
+void __gba_arenapairflip(__gba_arena_pair_t* region) {
+	if(region == nullptr) return;
+	reinterpret_cast<arenaPairType*>(region) -> flip();
+}
+
+// Release the blocks of the arena pair.
+void __gba_arenapairrelease(__gba_arena_pair_t* region) {
+	if(region == nullptr) return;
+	reinterpret_cast<arenaPairType*>(region) -> release();
+}
+
+/// @brief Masks the interrupts via the master register in its scope, and 
+/// restores the master register when leaving the scope.
+struct __gba_irqguard {
+	int master;
+	
+	__gba_irqguard() noexcept: master(__gba_interrupt_master) {
+		__gba_interrupt_master = 0;
+	}
+	
+	~__gba_irqguard() noexcept {
+		__gba_interrupt_master = master;
+	}
+};
+
+// Interrupt safe flavour of page allocation.
+__gba_page_t __gba_pagealloc_irqsafe(__gba_order_t pageOrder) {
+	__gba_irqguard guard;
+	return __gba_pagealloc(pageOrder);
+}
+
+// Interrupt safe flavour of page deallocation.
+void __gba_pagefree_irqsafe(__gba_page_t page, __gba_order_t pageOrder) {
+	__gba_irqguard guard;
+	__gba_pagefree(page, pageOrder);
+}
+
+// Interrupt safe flavour of reserved page allocation.
+__gba_page_t __gba_pagealloc_reserved_irqsafe(__gba_page_reserve_t* reserve) {
+	__gba_irqguard guard;
+	return __gba_pagealloc_reserved(reserve);
+}
+
+// Interrupt safe flavour of reserved page deallocation.
+void __gba_pagefree_reserved_irqsafe(__gba_page_reserve_t* reserve, __gba_page_t page) {
+	__gba_irqguard guard;
+	__gba_pagefree_reserved(reserve, page);
+}
+
+// Interrupt safe flavour of chunk allocation.
+__gba_chunk_t __gba_malloc_irqsafe(__gba_size_t chunkSize) {
+	__gba_irqguard guard;
+	return __gba_malloc(chunkSize);
+}
+
+// Interrupt safe flavour of chunk deallocation.
+void __gba_free_irqsafe(__gba_chunk_t chunk) {
+	if(chunk == nullptr) return;
+	__gba_irqguard guard;
+	__gba_free(chunk);
+}
+
+// Interrupt safe flavour of sized chunk allocation.
+__gba_chunk_t __gba_malloc_sized_irqsafe(__gba_size_t chunkSize) {
+	__gba_irqguard guard;
+	return __gba_malloc_sized(chunkSize);
+}
+
+// Interrupt safe flavour of sized chunk deallocation.
+void __gba_free_sized_irqsafe(__gba_chunk_t chunk, __gba_size_t chunkSize) {
+	if(chunk == nullptr) return;
+	__gba_irqguard guard;
+	__gba_free_sized(chunk, chunkSize);
+}
+
+// Interrupt safe flavour of heap allocation.
+__gba_chunk_t __gba_heap_malloc_irqsafe(__gba_malloc_allocator_t* region, __gba_size_t chunkSize) {
+	__gba_irqguard guard;
+	return __gba_heap_malloc(region, chunkSize);
+}
+
+// Interrupt safe flavour of heap deallocation.
+void __gba_heap_free_irqsafe(__gba_malloc_allocator_t* region, __gba_chunk_t chunk) {
+	if(chunk == nullptr) return;
+	__gba_irqguard guard;
+	__gba_heap_free(region, chunk);
+}
+
+// Interrupt safe flavour of slob allocation.
+__gba_chunk_t __gba_sloballoc_irqsafe(__gba_slob_allocator_t* region) {
+	__gba_irqguard guard;
+	return __gba_sloballoc(region);
+}
+
+// Interrupt safe flavour of slob deallocation.
+__gba_bool_t __gba_slobfree_irqsafe(__gba_slob_allocator_t* region, __gba_chunk_t memory) {
+	if(memory == nullptr) return TRUE;
+	__gba_irqguard guard;
+	return __gba_slobfree(region, memory);
+}
+
+// Interrupt safe flavour of bulk slob allocation.
+__gba_size_t __gba_sloballoc_n_irqsafe(__gba_slob_allocator_t* region, 
+	__gba_chunk_t* chunks, __gba_size_t count) {
+	__gba_irqguard guard;
+	return __gba_sloballoc_n(region, chunks, count);
+}
+
+// Interrupt safe flavour of bulk slob deallocation.
+__gba_size_t __gba_slobfree_n_irqsafe(__gba_slob_allocator_t* region, 
+	__gba_chunk_t* chunks, __gba_size_t count) {
+	__gba_irqguard guard;
+	return __gba_slobfree_n(region, chunks, count);
+}
+
+// Interrupt safe flavour of arena allocation.
+__gba_chunk_t __gba_arenaalloc_irqsafe(__gba_arena_allocator_t* region,
+	__gba_size_t chunkSize, __gba_size_t alignment) {
+	__gba_irqguard guard;
+	return __gba_arenaalloc(region, chunkSize, alignment);
+}
+
+#ifdef __gba_mmstat
+static_assert(__gba_ewram_info::maxPageOrder <= sizeof(__gba_pagestat_t::freeBlocks) 
+	/ sizeof(__gba_size_t), "The free blocks of page statistics could not hold every order.");
+
+// Retrieve the statistics of the page allocator.
+__gba_bool_t __gba_pagestat(__gba_page_allocator_t* region, __gba_pagestat_t* stat) {
+	if(stat == nullptr) return FALSE;
+	pageAllocatorType* allocator = (region != nullptr)? 
+		reinterpret_cast<pageAllocatorType*>(region) : pageAllocator;
+	if(allocator == nullptr) return FALSE;
+	__gba_memset(stat, 0, sizeof(__gba_pagestat_t));
+	
+	stat -> totalPages = allocator -> totalPageFrame();
+	stat -> lowBreak = allocator -> lpbrk;
+	stat -> highBreak = allocator -> hpbrk;
+	stat -> peakBreak = allocator -> peakPageFrame();
+	for(__gba_order_t order = 0; order < __gba_ewram_info::maxPageOrder; ++ order) {
+		stat -> cachedPages += allocator -> cachedPageCount(order) << order;
+		stat -> freeBlocks[order] = allocator -> freeBlockCount(order);
+		stat -> freePages += stat -> freeBlocks[order] << order;
+	}
+	return TRUE;
+}
+
+// Retrieve the statistics of the malloc allocator or a heap.
+__gba_bool_t __gba_mallinfo(__gba_malloc_allocator_t* region, __gba_mallinfo_t* stat) {
+	if(stat == nullptr) return FALSE;
+	fineAllocatorType* allocator = (region != nullptr)? 
+		reinterpret_cast<fineAllocatorType*>(region) : fineAllocator;
+	if(allocator == nullptr) return FALSE;
+	__gba_memset(stat, 0, sizeof(__gba_mallinfo_t));
+	
+	stat -> heapBytes = allocator -> pageAllocator.lpbrk << __gba_ewram_info::pageSizeShift;
+	if(allocator -> topChunk != (fineAllocatorType::chunkType)__gba_ewram_info::nullChunkAddress)
+		stat -> topBytes = allocator -> topChunk -> size();
+	stat -> inUseBytes = allocator -> bytesInUse();
+	stat -> peakBytes = allocator -> peakBytesInUse();
+	
+	// Walk the bins, where the small bin 0 below the node size is never used.
+	__gba_size_t& largest = stat -> largestFreeChunk;
+	for(unsigned int index = 1; index < fineAllocatorType::smallBinCount; ++ index)
+		fineAllocatorType::countBin(*(allocator -> smallBinNode(index)), 
+			stat -> smallChunks, stat -> smallBytes, largest);
+	for(__gba_order_t order = 0; order < fineAllocatorType::treeBinCount; ++ order)
+		fineAllocatorType::countTree(allocator -> tree[order], 
+			stat -> largeChunks, stat -> largeBytes, largest);
+	fineAllocatorType::countBin(allocator -> unsorted, 
+		stat -> unsortedChunks, stat -> unsortedBytes, largest);
+	return TRUE;
+}
+
+// Retrieve the statistics of the slob allocator of certain type.
+template<typename allocatorType>
+static void slobStatOf(const allocatorType* allocator, __gba_slobstat_t* stat) {
+	typename allocatorType::addressType used = 0, capacity = 0;
+	stat -> fullFrames = allocator -> countFrames(allocator -> full, used, capacity);
+	stat -> partialFrames = allocator -> countFrames(allocator -> partial, used, capacity);
+	stat -> freeFrames = allocator -> countFrames(allocator -> sfree, used, capacity);
+	stat -> usedObjects = used;
+	stat -> capacityObjects = capacity;
+	stat -> peakObjects = allocator -> peakObjects();
+}
+
+// Retrieve the statistics of the slob allocator based on slob type.
+__gba_bool_t __gba_slobstat(__gba_slob_allocator_t* region, __gba_slobstat_t* stat) {
+	if(region == nullptr || stat == nullptr) return FALSE;
+	__gba_memset(stat, 0, sizeof(__gba_slobstat_t));
+	switch(region -> type) {
+		case slobNormalTypeId: {
+			slobStatOf(reinterpret_cast<slobNormalAllocatorType*>(region -> data), stat);
+			return TRUE;
+		} break;
+		
+		case slobPow2TypeId: {
+			slobStatOf(reinterpret_cast<slobPow2AllocatorType*>(region -> data), stat);
+			return TRUE;
+		} break;
+		
+		default: {
+			return FALSE;
+		} break;
+	}
+}
+#endif
@@ -0,0 +1,69 @@
+/**
+ * @file gbanew.cpp
+ * @brief Global allocation operators for gba.
+ * @author Haoran Luo
+ *
+ * Defines the global operator new and delete over the gba/mm.h, which is
+ * optional and not archived into the library. Link with it explicitly to
+ * route the C++ allocations into the memory management of this library.
+ *
+ * The small objects are allocated from the slob caches of size classes,
+ * and the rest from the malloc allocator. The sized delete knows the
+ * owner of the object without decoding its frame header.
+ *
+ * As the library is built without exceptions, the operator new traps on
+ * exhaustion instead of throwing std::bad_alloc, since the compiler assumes
+ * its result is never null. Only the nothrow flavours return null pointer.
+ */
+#include "gba/mm.h"
+#include <new>
+
+// Allocate or trap, which stands for throwing std::bad_alloc.
+static inline void* __gba_new(std::size_t size) noexcept {
+	void* memory = __gba_malloc_sized(size);
+	if(memory == nullptr) __builtin_trap();
+	return memory;
+}
+
+// Allocation operators.
+void* operator new(std::size_t size) {
+	return __gba_new(size);
+}
+
+void* operator new[](std::size_t size) {
+	return __gba_new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+	return __gba_malloc_sized(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+	return __gba_malloc_sized(size);
+}
+
+// Deallocation operators, whose owner is decoded from the frame header.
+void operator delete(void* memory) noexcept {
+	__gba_free_sized(memory, 0);
+}
+
+void operator delete[](void* memory) noexcept {
+	__gba_free_sized(memory, 0);
+}
+
+void operator delete(void* memory, const std::nothrow_t&) noexcept {
+	__gba_free_sized(memory, 0);
+}
+
+void operator delete[](void* memory, const std::nothrow_t&) noexcept {
+	__gba_free_sized(memory, 0);
+}
+
+// Sized deallocation operators, whose owner is known from the size.
+void operator delete(void* memory, std::size_t size) noexcept {
+	__gba_free_sized(memory, size);
+}
+
+void operator delete[](void* memory, std::size_t size) noexcept {
+	__gba_free_sized(memory, size);
+}
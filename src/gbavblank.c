@@ -0,0 +1,139 @@
+/**
+ * gbavblank.c - VBlank deferred work queue for GBA.
+ * @author Haoran Luo
+ *
+ * Implementation for the VBlank work queue defined in
+ * gba/vblank.h. See the header file for usage and
+ * documentation details.
+ *
+ * The remained time of the VBlank period is derived from
+ * the vertical counter rather than the sum of estimated
+ * costs, so an inaccurate estimation never accumulates.
+ */
+#include "gba/vblank.h"
+#include "gba/interrupt.h"
+#include "gba/video.h"
+
+// The number of scanlines in a frame.
+#define __gba_vblank_framelines 228
+
+// The queues of each priority, as singly linked list with tail pointer.
+static __gba_vblank_work_t* __gba_vblank_heads[__gba_vblank_priorities];
+static __gba_vblank_work_t** __gba_vblank_tails[__gba_vblank_priorities];
+static volatile unsigned int __gba_vblank_count = 0;
+
+// Whether the queue has been attached to the dispatcher.
+static int __gba_vblank_initialized = 0;
+
+// Retrieve the remained cycles in the VBlank period.
+static unsigned int __gba_vblank_remained() {
+	if(!__gba_video_status.bits.vblank) return 0;
+	unsigned int line = __gba_video_vcounter & 0x0ff;
+	if(line >= __gba_vblank_framelines) return 0;
+	return (__gba_vblank_framelines - line) * __gba_vblank_linecycles;
+}
+
+// Put the detached works from the priority on back before the works
+// enqueued while running, so that they keep their order.
+static void __gba_vblank_restore(__gba_vblank_work_t** heads,
+	__gba_vblank_work_t*** tails, unsigned int priority) {
+	for(; priority < __gba_vblank_priorities; ++ priority) {
+		if(heads[priority] == 0) continue;
+		*tails[priority] = __gba_vblank_heads[priority];
+		if(__gba_vblank_heads[priority] == 0)
+			__gba_vblank_tails[priority] = tails[priority];
+		__gba_vblank_heads[priority] = heads[priority];
+	}
+}
+
+// Run the works in priority order, under interrupt context. The works of
+// all priorities are detached before running any, so that the works
+// enqueued while running (including the work itself) wait for the next
+// period, whatever their priorities are.
+static void __gba_vblank_service(unsigned short raised) {
+	(void) raised;
+	__gba_vblank_work_t* heads[__gba_vblank_priorities];
+	__gba_vblank_work_t** tails[__gba_vblank_priorities];
+	unsigned int priority;
+	for(priority = 0; priority < __gba_vblank_priorities; ++ priority) {
+		heads[priority] = __gba_vblank_heads[priority];
+		tails[priority] = __gba_vblank_tails[priority];
+		__gba_vblank_heads[priority] = 0;
+		__gba_vblank_tails[priority] = &__gba_vblank_heads[priority];
+	}
+
+	int hasRun = 0;
+	for(priority = 0; priority < __gba_vblank_priorities; ++ priority) {
+		while(heads[priority] != 0) {
+			// Stop when the work could not fit in, and put the remained works
+			// back. The first work of each period is always run, so that an
+			// oversized work never blocks.
+			__gba_vblank_work_t* work = heads[priority];
+			if(hasRun && work -> cost > __gba_vblank_remained()) {
+				__gba_vblank_restore(heads, tails, priority);
+				return;
+			}
+
+			// Remove the work from the queue before running it, so that
+			// the work could enqueue itself again.
+			heads[priority] = work -> next;
+			work -> next = 0;
+			work -> queued = 0;
+			-- __gba_vblank_count;
+
+			work -> work(work -> context);
+			hasRun = 1;
+		}
+	}
+}
+
+// The service node attached to the dispatcher.
+static __gba_interrupt_service_t __gba_vblank_interrupt = {
+	im_vblank, __gba_vblank_service, 0
+};
+
+// Implementation for initializing the work queue.
+void __gba_vblank_init() {
+	if(__gba_vblank_initialized) return;
+
+	unsigned int priority;
+	for(priority = 0; priority < __gba_vblank_priorities; ++ priority) {
+		__gba_vblank_heads[priority] = 0;
+		__gba_vblank_tails[priority] = &__gba_vblank_heads[priority];
+	}
+
+	__gba_video_status.bits.vblank_irq_enabled = 1;
+	__gba_interrupt_attach(&__gba_vblank_interrupt);
+	__gba_vblank_initialized = 1;
+}
+
+// Implementation for enqueuing work.
+int __gba_vblank_enqueue(__gba_vblank_work_t* work) {
+	if(!__gba_vblank_initialized) return 0;
+	if(work == 0 || work -> work == 0) return 0;
+	if(work -> priority >= __gba_vblank_priorities) return 0;
+
+	// The queue should not be visited by the service while modifying.
+	int master = __gba_interrupt_master;
+	__gba_interrupt_master = 0;
+
+	// Enqueuing a queued work again would corrupt the queue.
+	if(work -> queued) {
+		__gba_interrupt_master = master;
+		return 0;
+	}
+
+	work -> next = 0;
+	work -> queued = 1;
+	*__gba_vblank_tails[work -> priority] = work;
+	__gba_vblank_tails[work -> priority] = &(work -> next);
+	++ __gba_vblank_count;
+
+	__gba_interrupt_master = master;
+	return 1;
+}
+
+// Implementation for retrieving the number of pending works.
+unsigned int __gba_vblank_pending() {
+	return __gba_vblank_count;
+}
@@ -0,0 +1,128 @@
+/**
+ * @file test/objpool.cpp
+ * @brief Host test of the typed object pool.
+ * @author Haoran Luo
+ *
+ * The pool is instantiated over a trivial page allocator managing a static
+ * region of the host memory. The stale and forged handles, including the
+ * handles referring to free slots, should never reach an object.
+ */
+#include "gmlibc/objpool.hpp"
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+// The region where the pages are allocated.
+alignas(2048) static char region[64 * 2048];
+
+// The information of the slob allocator on the host.
+struct hostInfo {
+	typedef unsigned char orderType;
+	static constexpr orderType maxPageOrder = 6;
+	static constexpr orderType pageSizeShift = 11;
+	typedef std::intptr_t addressType;
+	static constexpr addressType nullPageAddress = 0;
+	static constexpr bool collectStatistics = false;
+	typedef unsigned short objectNumberType;
+	static constexpr bool deftSlobDeallocate = true;
+};
+
+// The page allocator handing out pages from the top of the region, and
+// keeping the freed pages in lists per order.
+struct hostPageAllocator {
+	typedef char* pageType;
+	char* highBreak = region + sizeof(region);
+	char* freePages[hostInfo::maxPageOrder] = {};
+	
+	hostInfo::addressType firstPageAddress() const noexcept {
+		return reinterpret_cast<hostInfo::addressType>(region);
+	}
+	
+	pageType allocateHighPage(hostInfo::orderType order) noexcept {
+		if(freePages[order] != nullptr) {
+			char* page = freePages[order];
+			std::memcpy(&freePages[order], page, sizeof(char*));
+			return page;
+		}
+		std::size_t pageSize = std::size_t(1) << (hostInfo::pageSizeShift + order);
+		if(std::size_t(highBreak - region) < pageSize) return nullptr;
+		return highBreak -= pageSize;
+	}
+	
+	void freeHighPage(pageType page, hostInfo::orderType order) noexcept {
+		std::memcpy(page, &freePages[order], sizeof(char*));
+		freePages[order] = page;
+	}
+};
+
+// The object counting its live instances.
+static int liveObjects = 0;
+struct object {
+	int value;
+	object(int value) noexcept: value(value) { ++ liveObjects; }
+	~object() noexcept { -- liveObjects; }
+};
+typedef GmOsObjectPool<object, hostInfo, hostPageAllocator, 4096> poolType;
+
+static int failures = 0;
+#define expect(condition) do { if(!(condition)) { \
+	std::printf("%s:%d: expected %s\n", __FILE__, __LINE__, #condition); \
+	++ failures; } } while(0)
+
+int main() {
+	hostPageAllocator pageAllocator;
+	poolType pool(pageAllocator);
+	
+	// Create and look up the objects.
+	poolType::handleType a = pool.create(1), b = pool.create(2), c = pool.create(3);
+	expect(a != poolType::nullHandle && pool.get(a) -> value == 1);
+	expect(pool.get(b) -> value == 2 && pool.get(c) -> value == 3);
+	expect(pool.size() == 3 && liveObjects == 3);
+	
+	// The handle of a never used slot matches the initial generation.
+	poolType::handleType unissued = poolType::handleFrom(7, 1);
+	expect(pool.get(unissued) == nullptr);
+	pool.destroy(unissued);
+	expect(pool.size() == 3 && liveObjects == 3);
+	
+	// The handle forged with the current generation of a free slot.
+	unsigned short slot = poolType::slotOf(a);
+	pool.destroy(a);
+	expect(pool.get(a) == nullptr && pool.size() == 2 && liveObjects == 2);
+	poolType::handleType forged = poolType::handleFrom(slot, pool.slots[slot].generation);
+	expect(pool.get(forged) == nullptr);
+	pool.destroy(forged);
+	pool.destroy(forged);
+	expect(pool.size() == 2 && liveObjects == 2);
+	expect(pool.get(b) -> value == 2 && pool.get(c) -> value == 3);
+	
+	// The free slot whose next free slot is still below the object count.
+	poolType::handleType g = pool.create(6), h = pool.create(7), i = pool.create(8);
+	pool.destroy(g);
+	pool.destroy(h);
+	slot = poolType::slotOf(h);
+	expect(pool.slots[slot].position < pool.size());
+	forged = poolType::handleFrom(slot, pool.slots[slot].generation);
+	expect(pool.get(forged) == nullptr);
+	pool.destroy(forged);
+	expect(pool.size() == 3 && liveObjects == 3);
+	expect(pool.get(i) -> value == 8 && pool.get(b) -> value == 2);
+	
+	// The free list is intact, so the slots are reused exactly once.
+	poolType::handleType d = pool.create(4), e = pool.create(5);
+	expect(poolType::slotOf(d) != poolType::slotOf(e));
+	expect(pool.get(d) -> value == 4 && pool.get(e) -> value == 5);
+	
+	// Wrap the generation of a slot, and the wrapped handle of the free slot.
+	for(int i = 0; i < 40; ++ i) {
+		poolType::handleType f = pool.create(i);
+		pool.destroy(f);
+		expect(pool.get(f) == nullptr);
+	}
+	expect(pool.size() == 5 && liveObjects == 5);
+	
+	pool.clear();
+	expect(pool.size() == 0 && liveObjects == 0);
+	if(failures == 0) std::printf("objpool: passed\n");
+	return failures == 0? 0 : 1;
+}